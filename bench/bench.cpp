@@ -0,0 +1,413 @@
+#include "hlt/game.hpp"
+#include "hlt/input.hpp"
+#include "hlt/node_pool.hpp"
+#include "my_helpers/alloc_tracker.hpp"
+#include "my_helpers/bot.hpp"
+#include "my_helpers/movement_map.hpp"
+#include "my_helpers/navigator.hpp"
+#include "my_helpers/potential_field.hpp"
+#include "my_helpers/tunables.hpp"
+#include "my_helpers/turn_arena.hpp"
+#include "sim/simulator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace hlt;
+
+/// Times the hot paths of a turn on real game states and compares them
+/// against a saved baseline.
+///
+/// Usage: bench [--turns N] [--repeat N] [--threads N] [--save file] [--compare file]
+///              [--threshold %] [transcript...]
+/// The states are every turn of one simulated game per map size (32 to 64)
+/// and player count (2 and 4), seen from seat 0, plus every turn of the
+/// given engine transcripts (see replay). With --turns, only N turns from the
+/// middle of each game are timed; the games are still played in full, since
+/// the bot plays a shortened game differently. For each state it times:
+///   GameMap::_update       parsing the turn's halite changes into a map
+///   PotentialField         the full potential pass (calculateMaxHalitePotential)
+///   Navigator              setting up the navigator, incremental potential included
+///   Navigator::explore     planning and exploring, per ship, with every ship exploring
+///   MovementMap            collecting the intents and resolving the conflicts
+///   Bot::playTurn          the whole turn, as played in the game
+/// and reports ns and heap allocations per operation. Every scenario is run
+/// --repeat times (3 by default) and each state counts with its fastest time,
+/// to keep the noise down. With --compare, an operation more than --threshold
+/// percent (10 by default) slower than the baseline, or allocating more, makes
+/// the exit code 1; on a busy machine use more repeats or a higher threshold.
+/// So does any turn but the first making more than Bot::TURN_ALLOCATION_BUDGET
+/// heap allocations in Bot::playTurn, logging included, baseline or not.
+/// --threads plans on that many threads, as Bot::setPlanningThreads (1 by
+/// default, 0 for every hardware thread).
+/// Run it from the folder holding the csv folder.
+
+/// One operation over all the states of a scenario.
+struct Measurement {
+    vector<long long> ns; // of every state, in order
+    long long ops = 0;
+    long long allocations = 0;
+    long long worstAllocations = 0; // the most of any state but the first, which sets up the buffers
+
+    long long totalNs() const { return accumulate(ns.begin(), ns.end(), 0LL); }
+    double nsPerOp() const { return ops ? double(totalNs()) / ops : 0; }
+    double allocationsPerOp() const { return ops ? double(allocations) / ops : 0; }
+};
+
+/// Runs f, which does ops operations on the next state, and adds its time and allocations to m.
+template <typename F>
+void measure(Measurement& m, long long ops, F&& f) {
+    const long long allocationsBefore = AllocTracker::allocations();
+    const auto start = chrono::steady_clock::now();
+    f();
+    const auto end = chrono::steady_clock::now();
+    const long long allocations = AllocTracker::allocations() - allocationsBefore;
+    m.allocations += allocations;
+    if (!m.ns.empty()) {
+        m.worstAllocations = max(m.worstAllocations, allocations);
+    }
+    m.ns.push_back(chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+    m.ops += ops;
+}
+
+static const vector<string> OPERATIONS = {
+    "GameMap::_update", "PotentialField", "Navigator", "Navigator::explore", "MovementMap", "Bot::playTurn",
+};
+
+typedef map<string, Measurement> Measurements;
+
+/// Keep the fastest time of every state over the runs. The games are
+/// deterministic, so every run sees the same states and does the same operations.
+void keepFastest(Measurements& best, const Measurements& run) {
+    for (const auto& operation : run) {
+        auto found = best.find(operation.first);
+        if (found == best.end()) {
+            best[operation.first] = operation.second;
+            continue;
+        }
+        vector<long long>& ns = found->second.ns;
+        for (size_t i = 0; i < ns.size() && i < operation.second.ns.size(); i++) {
+            ns[i] = min(ns[i], operation.second.ns[i]);
+        }
+    }
+}
+
+/// Seat 0 of a game: plays it with the bot and, before each turn, times the
+/// parts of that turn on copies of the planning state, so the game is the
+/// same as without the benchmarks.
+class BenchSeat {
+public:
+    /// timedTurns: how many turns from the middle of the game to time, 0 for all.
+    BenchSeat(Game& game, shared_ptr<const Tunables> tunables, int timedTurns, unsigned int planningThreads,
+              Measurements& results) :
+        bot_(game, 0, tunables),
+        timedTurns_(timedTurns),
+        tunables_(*tunables, int(game.players.size()), game.game_map->width, Bot::findHaliteAbundanceKey(game)),
+        rng_(0),
+        shipNodes_(2 * size_t(game.game_map->width) * game.game_map->height),
+        shipStatus_(&shipNodes_), exploreTargets_(&shipNodes_),
+        movementMap_(game.game_map, game.me, int(game.players.size()), game.constants.MAX_HALITE),
+        scratchMap_(GameMap::_generate(game.game_map->width, game.game_map->height, game.game_map->halite)),
+        results_(results) {
+        bot_.setPlanningThreads(planningThreads);
+        // the same games in every round and against the baseline
+        bot_.setTimeLimited(false);
+        if (planningThreads == 0) {
+            planningThreads = max(1u, thread::hardware_concurrency());
+        }
+        if (planningThreads > 1) {
+            pool_ = make_unique<WorkStealingPool>(planningThreads - 1);
+        }
+    }
+
+    vector<Command> playTurn(Game& game) {
+        if (!timed(game)) {
+            followGame(game);
+            return bot_.playTurn(game);
+        }
+        benchUpdate(game, true);
+        benchPlanning(game);
+        const vector<Command>* commands = nullptr;
+        measure(results_["Bot::playTurn"], 1, [&] { commands = &bot_.playTurn(game); });
+        return *commands;
+    }
+
+private:
+    bool timed(const Game& game) const {
+        if (timedTurns_ == 0) {
+            return true;
+        }
+        const int first = max(1, (game.constants.MAX_TURNS - timedTurns_) / 2 + 1);
+        return game.turn_number >= first && game.turn_number < first + timedTurns_;
+    }
+
+    /// Bring the copies of the planning state up to date on a turn that is not timed,
+    /// so the first timed turn does not pay for the ones before it.
+    void followGame(Game& game) {
+        benchUpdate(game, false);
+        shared_ptr<Player>& me = game.me;
+        potentialField_.update(*game.game_map, me->shipyard->position, me->home_distance,
+                               tunables_.lookUpTunable(Tunable::hltCorr0), tunables_.lookUpTunable(Tunable::hltCorr1));
+    }
+
+    /// The turn's halite changes, in the engine's words, parsed into a map of our own.
+    void benchUpdate(Game& game, bool timed) {
+        const GameMap& map = *game.game_map;
+        ostringstream text;
+        text << map.changed_cells.size() << '\n';
+        for (int cell : map.changed_cells) {
+            text << cell % map.width << ' ' << cell / map.width << ' ' << map.halite[cell] << '\n';
+        }
+        Input input = Input::from_string(text.str());
+        if (timed) {
+            measure(results_["GameMap::_update"], 1, [&] { scratchMap_->_update(input); });
+        }
+        else {
+            scratchMap_->_update(input);
+        }
+    }
+
+    void benchPlanning(Game& game) {
+        shared_ptr<Player>& me = game.me;
+        const Position& shipyard = me->shipyard->position;
+        measure(results_["PotentialField"], 1, [&] {
+            PotentialField field;
+            field.update(*game.game_map, shipyard, me->home_distance,
+                         tunables_.lookUpTunable(Tunable::hltCorr0), tunables_.lookUpTunable(Tunable::hltCorr1));
+        });
+
+        // every ship explores, from scratch, to time the search at its heaviest
+        TurnBudget budget = TurnBudget::unlimited();
+        arena_.reset();
+        pmr::memory_resource* memory = arena_.resource();
+        // cleared rather than rebuilt, so their nodes are reused as in the bot
+        shipStatus_.clear();
+        exploreTargets_.clear();
+        pmr::vector<Ship*> ships(memory);
+        for (const auto& ship_iterator : me->ships) {
+            shipStatus_[ship_iterator.first] = ShipStatus::EXPLORE;
+            ships.push_back(ship_iterator.second);
+        }
+        unique_ptr<Navigator> navigator;
+        measure(results_["Navigator"], 1, [&] {
+            navigator = make_unique<Navigator>(game.game_map, me, game.boards, shipStatus_, rng_, exploreTargets_,
+                                               potentialField_, budget, tunables_, pool_.get(), memory);
+        });
+        pmr::vector<pmr::vector<Direction>> directions(ships.size(), memory);
+        measure(results_["Navigator::explore"], ships.size(), [&] {
+            navigator->planExploreTargets(ships);
+            for (size_t i = 0; i < ships.size(); i++) {
+                directions[i] = navigator->explore(ships[i]);
+            }
+        });
+
+        measure(results_["MovementMap"], 1, [&] {
+            movementMap_.startTurn(false, game.boards, budget);
+            for (size_t i = 0; i < ships.size(); i++) {
+                movementMap_.addIntent(ships[i], directions[i]);
+            }
+            movementMap_.processOutputs(me);
+        });
+    }
+
+    Bot bot_;
+    int timedTurns_;
+    GameTunables tunables_;
+    mt19937 rng_;
+    NodePool shipNodes_;
+    pmr::unordered_map<EntityId, ShipStatus> shipStatus_;
+    pmr::unordered_map<EntityId, int> exploreTargets_;
+    PotentialField potentialField_;
+    MovementMap movementMap_;
+    shared_ptr<GameMap> scratchMap_;
+    TurnArena arena_;
+    unique_ptr<WorkStealingPool> pool_;
+    Measurements& results_;
+};
+
+Measurements benchSimulatedGame(int mapSize, int nPlayers, int timedTurns, unsigned int threads,
+                                shared_ptr<const Tunables> tunables) {
+    SimulationConfig config;
+    config.mapSize = mapSize;
+    config.nPlayers = nPlayers;
+    config.seed = 1;
+    Measurements results;
+    vector<PlayerFactory> players;
+    players.push_back([&](Game& game) -> TurnFunction {
+        shared_ptr<BenchSeat> seat = make_shared<BenchSeat>(game, tunables, timedTurns, threads, results);
+        return [seat](Game& game) { return seat->playTurn(game); };
+    });
+    for (int id = 1; id < nPlayers; id++) {
+        players.push_back(Simulator::botPlayer(config.seed + id, tunables));
+    }
+    Simulator(config).run(players);
+    return results;
+}
+
+Measurements benchTranscript(const string& transcript, int timedTurns, unsigned int threads,
+                             shared_ptr<const Tunables> tunables) {
+    Measurements results;
+    Game game(Input::from_string(transcript));
+    BenchSeat seat(game, tunables, timedTurns, threads, results);
+    while (!game.input.at_end()) {
+        game.update_frame();
+        seat.playTurn(game);
+    }
+    return results;
+}
+
+/// scenario -> operation -> ns and allocations per operation, as --save writes them.
+typedef map<string, map<string, pair<double, double>>> Baseline;
+
+Baseline readBaseline(const string& path) {
+    Baseline baseline;
+    ifstream file(path);
+    string scenario, operation;
+    double ns, allocations;
+    while (file >> scenario >> operation >> ns >> allocations) {
+        baseline[scenario][operation] = { ns, allocations };
+    }
+    return baseline;
+}
+
+int main(int argc, char* argv[]) {
+    int timedTurns = 0;
+    int repeats = 3;
+    unsigned int threads = 1;
+    double thresholdPercent = 10;
+    string savePath;
+    string comparePath;
+    vector<string> transcripts;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--turns" && i + 1 < argc) {
+            timedTurns = stoi(argv[++i]);
+        }
+        else if (arg == "--repeat" && i + 1 < argc) {
+            repeats = max(1, stoi(argv[++i]));
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            threads = unsigned(stoul(argv[++i]));
+        }
+        else if (arg == "--threshold" && i + 1 < argc) {
+            thresholdPercent = stod(argv[++i]);
+        }
+        else if (arg == "--save" && i + 1 < argc) {
+            savePath = argv[++i];
+        }
+        else if (arg == "--compare" && i + 1 < argc) {
+            comparePath = argv[++i];
+        }
+        else {
+            transcripts.push_back(arg);
+        }
+    }
+
+    // the bots log at their own level, so the allocation check covers it; the
+    // simulated games never open the log, so theirs end up in bot-unknown-*.log
+    shared_ptr<const Tunables> tunables = Tunables::load(".");
+
+    // a scenario is a name and a way to play it once
+    vector<pair<string, function<Measurements()>>> runs;
+    for (int nPlayers : { 2, 4 }) {
+        for (int mapSize = 32; mapSize <= 64; mapSize += 8) {
+            runs.push_back({ to_string(mapSize) + "x" + to_string(nPlayers) + "p",
+                             [=] { return benchSimulatedGame(mapSize, nPlayers, timedTurns, threads, tunables); } });
+        }
+    }
+    for (const string& path : transcripts) {
+        ifstream file(path, ios::binary);
+        if (!file) {
+            cerr << "cannot open " << path << endl;
+            return 1;
+        }
+        string transcript((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+        runs.push_back({ path.substr(path.find_last_of("\\/") + 1),
+                         [=] { return benchTranscript(transcript, timedTurns, threads, tunables); } });
+    }
+
+    // the repeats go round all the scenarios, so a slow spell of the host
+    // is spread over them rather than spoiling every run of one
+    vector<pair<string, Measurements>> scenarios;
+    for (const auto& run : runs) {
+        scenarios.push_back({ run.first, Measurements() });
+    }
+    for (int round = 0; round < repeats; round++) {
+        cerr << "round " << round + 1 << " of " << repeats << endl;
+        for (size_t i = 0; i < runs.size(); i++) {
+            keepFastest(scenarios[i].second, runs[i].second());
+        }
+    }
+
+    Baseline baseline;
+    if (!comparePath.empty()) {
+        baseline = readBaseline(comparePath);
+        if (baseline.empty()) {
+            cerr << "no baseline in " << comparePath << endl;
+            return 1;
+        }
+    }
+    const double slowerRatio = 1 + thresholdPercent / 100;
+    int regressions = 0;
+    int overBudget = 0;
+
+    ofstream save;
+    if (!savePath.empty()) {
+        save.open(savePath);
+    }
+    cout << fixed << setprecision(1);
+    cout << left << setw(14) << "scenario" << setw(20) << "operation" << right
+         << setw(12) << "ns/op" << setw(12) << "allocs/op" << setw(10) << "ops";
+    if (!baseline.empty()) {
+        cout << setw(10) << "time" << setw(12) << "allocs";
+    }
+    cout << endl;
+    for (const auto& scenario : scenarios) {
+        for (const string& operation : OPERATIONS) {
+            auto found = scenario.second.find(operation);
+            if (found == scenario.second.end()) {
+                continue;
+            }
+            const Measurement& m = found->second;
+            cout << left << setw(14) << scenario.first << setw(20) << operation << right
+                 << setw(12) << m.nsPerOp() << setw(12) << m.allocationsPerOp() << setw(10) << m.ops;
+            if (save.is_open()) {
+                save << scenario.first << ' ' << operation << ' ' << m.nsPerOp() << ' ' << m.allocationsPerOp() << '\n';
+            }
+            if (!baseline.empty() && baseline[scenario.first].count(operation)) {
+                const pair<double, double>& base = baseline[scenario.first][operation];
+                const double change = base.first > 0 ? 100 * (m.nsPerOp() / base.first - 1) : 0;
+                cout << setw(9) << showpos << change << noshowpos << '%'
+                     << setw(12) << m.allocationsPerOp() - base.second;
+                if (m.nsPerOp() > base.first * slowerRatio || m.allocationsPerOp() > base.second + 0.05) {
+                    cout << "  REGRESSION";
+                    regressions++;
+                }
+            }
+            if (operation == "Bot::playTurn" && m.worstAllocations > Bot::TURN_ALLOCATION_BUDGET) {
+                cout << "  OVER BUDGET (" << m.worstAllocations << " allocations in a turn)";
+                overBudget++;
+            }
+            cout << endl;
+        }
+    }
+    if (!baseline.empty()) {
+        cout << regressions << " regressions against " << comparePath << endl;
+    }
+    if (overBudget > 0) {
+        cout << overBudget << " scenarios over the turn allocation budget of " << Bot::TURN_ALLOCATION_BUDGET << endl;
+    }
+    return regressions == 0 && overBudget == 0 ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+#include "hlt/game.hpp"
+#include "hlt/input.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace hlt;
+
+/// Replays engine input through the turn parser and reports the time per turn.
+///
+/// Usage: parse_bench [transcript] [iterations]
+/// The transcript is whatever the engine wrote to the bot's stdin, for example
+/// captured by running the bot as 'tee input.txt | ./MyBot'. Without one, a
+/// 64x64 4-player game with a late-game fleet is synthesized.
+
+/// Synthesize engine input for a game where every player keeps spawning ships
+/// that random-walk without ever sharing a cell.
+string synthesizeTranscript(int mapSize, int nPlayers, int nTurns, unsigned int seed) {
+    mt19937 rng(seed);
+    ostringstream out;
+    out << "{\"NEW_ENTITY_ENERGY_COST\":1000,\"DROPOFF_COST\":4000,\"MAX_ENERGY\":1000,"
+        << "\"MAX_TURNS\":" << nTurns << ",\"EXTRACT_RATIO\":4,\"MOVE_COST_RATIO\":10,"
+        << "\"INSPIRATION_ENABLED\":true,\"INSPIRATION_RADIUS\":4,\"INSPIRATION_SHIP_COUNT\":2,"
+        << "\"INSPIRED_EXTRACT_RATIO\":4,\"INSPIRED_BONUS_MULTIPLIER\":2.0,\"INSPIRED_MOVE_COST_RATIO\":10}\n";
+    out << nPlayers << " 0\n";
+
+    vector<Position> shipyards;
+    for (int p = 0; p < nPlayers; p++) {
+        int x = (p % 2 == 0) ? mapSize / 4 : 3 * mapSize / 4;
+        int y = (nPlayers == 2) ? mapSize / 2 : ((p < 2) ? mapSize / 4 : 3 * mapSize / 4);
+        shipyards.push_back(Position(x, y));
+        out << p << ' ' << x << ' ' << y << '\n';
+    }
+
+    out << mapSize << ' ' << mapSize << '\n';
+    vector<int> halite(mapSize * mapSize);
+    for (int y = 0; y < mapSize; y++) {
+        for (int x = 0; x < mapSize; x++) {
+            halite[y * mapSize + x] = rng() % 1000;
+            out << halite[y * mapSize + x] << (x + 1 < mapSize ? ' ' : '\n');
+        }
+    }
+
+    struct FakeShip { EntityId id; int x; int y; int halite; };
+    vector<vector<FakeShip>> ships(nPlayers);
+    set<pair<int, int>> occupied;
+    EntityId nextId = 0;
+    for (int turn = 1; turn <= nTurns; turn++) {
+        out << turn << '\n';
+        for (int p = 0; p < nPlayers; p++) {
+            for (FakeShip& ship : ships[p]) {
+                int dir = rng() % 5;
+                int nx = (ship.x + (dir == 1) - (dir == 2) + mapSize) % mapSize;
+                int ny = (ship.y + (dir == 3) - (dir == 4) + mapSize) % mapSize;
+                if (!occupied.count({nx, ny})) {
+                    occupied.erase({ship.x, ship.y});
+                    occupied.insert({nx, ny});
+                    ship.x = nx;
+                    ship.y = ny;
+                }
+                ship.halite = min(1000, ship.halite + (int)(rng() % 80));
+            }
+            Position yard = shipyards[p];
+            if (turn % 3 == 1 && ships[p].size() < 100 && !occupied.count({yard.x, yard.y})) {
+                ships[p].push_back({nextId++, yard.x, yard.y, 0});
+                occupied.insert({yard.x, yard.y});
+            }
+            out << p << ' ' << ships[p].size() << " 0 " << 5000 + turn * 37 << '\n';
+            for (const FakeShip& ship : ships[p]) {
+                out << ship.id << ' ' << ship.x << ' ' << ship.y << ' ' << ship.halite << '\n';
+            }
+        }
+        int updates = rng() % 200;
+        out << updates << '\n';
+        for (int i = 0; i < updates; i++) {
+            int cell = rng() % (mapSize * mapSize);
+            halite[cell] = max(0, halite[cell] - (int)(rng() % 100));
+            out << cell % mapSize << ' ' << cell / mapSize << ' ' << halite[cell] << '\n';
+        }
+    }
+    return out.str();
+}
+
+/// What the starter kit did: one getline and one stringstream per line.
+long long parseWithStringStreams(const string& transcript) {
+    istringstream in(transcript);
+    string line;
+    long long checksum = 0;
+    getline(in, line); // constants
+    while (getline(in, line)) {
+        stringstream lineStream(line);
+        int value;
+        while (lineStream >> value) {
+            checksum += value;
+        }
+    }
+    return checksum;
+}
+
+int main(int argc, char* argv[]) {
+    string transcript;
+    if (argc > 1) {
+        ifstream file(argv[1]);
+        if (!file) {
+            cerr << "cannot open " << argv[1] << endl;
+            return 1;
+        }
+        transcript.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    }
+    else {
+        transcript = synthesizeTranscript(64, 4, 500, 42);
+    }
+    int iterations = argc > 2 ? stoi(argv[2]) : 5;
+
+    using Clock = chrono::steady_clock;
+
+    long long turns = 0;
+    Clock::duration replayTime = Clock::duration::zero();
+    for (int i = 0; i < iterations; i++) {
+        Input input = Input::from_string(transcript);
+        auto start = Clock::now();
+        Game game(std::move(input));
+        while (!game.input.at_end()) {
+            game.update_frame();
+            turns++;
+        }
+        replayTime += Clock::now() - start;
+    }
+
+    long long checksum = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; i++) {
+        checksum += parseWithStringStreams(transcript);
+    }
+    Clock::duration streamTime = Clock::now() - start;
+
+    auto nsPerTurn = [&](Clock::duration d) {
+        return turns ? chrono::duration_cast<chrono::nanoseconds>(d).count() / turns : 0;
+    };
+    cout << "transcript bytes:             " << transcript.size() << endl;
+    cout << "turns replayed:               " << turns << endl;
+    cout << "update_frame ns/turn:         " << nsPerTurn(replayTime) << endl;
+    cout << "stringstream tokenize ns/turn: " << nsPerTurn(streamTime)
+         << " (reference, checksum " << checksum << ")" << endl;
+    return 0;
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "types.hpp"
+#include "position.hpp"
+#include "direction.hpp"
+#include "player.hpp"
+#include "log.hpp"
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace hlt {
+    /** Number of set bits, with the compiler's builtin where there is one. */
+    inline int popcount64(uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_popcountll(bits);
+#else
+        return static_cast<int>(std::bitset<64>(bits).count());
+#endif
+    }
+
+    /**
+     * One bit per map cell, one 64 bit word per row, for maps up to 64 x 64.
+     * Shifts wrap around the edges like the map does, so whole-board questions
+     * ("which cells can an enemy reach next turn?") take a handful of word
+     * operations per row instead of a walk over ships and cells.
+     */
+    struct Bitboard {
+        static constexpr int MAX_SIZE = 64;
+
+        std::array<uint64_t, MAX_SIZE> rows{}; // bit x of rows[y] is cell (x, y)
+        int width = 0;
+        int height = 0;
+
+        Bitboard() = default;
+
+        Bitboard(int width, int height) : width(width), height(height) {
+            if (width > MAX_SIZE || height > MAX_SIZE) {
+                log::log("Error: bitboards only fit maps up to 64 x 64");
+                exit(1);
+            }
+        }
+
+        /** Positions must be normalized. */
+        void set(const Position& position) {
+            rows[position.y] |= uint64_t(1) << position.x;
+        }
+
+        bool test(const Position& position) const {
+            return (rows[position.y] >> position.x) & 1;
+        }
+
+        /** The board with every cell moved one step in direction, wrapping around. */
+        Bitboard shifted(Direction direction) const {
+            Bitboard result(width, height);
+            const uint64_t mask = width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+            switch (direction) {
+                case Direction::EAST:
+                    for (int y = 0; y < height; ++y) {
+                        result.rows[y] = ((rows[y] << 1) | (rows[y] >> (width - 1))) & mask;
+                    }
+                    break;
+                case Direction::WEST:
+                    for (int y = 0; y < height; ++y) {
+                        result.rows[y] = (rows[y] >> 1) | ((rows[y] & 1) << (width - 1));
+                    }
+                    break;
+                case Direction::SOUTH:
+                    result.rows[0] = rows[height - 1];
+                    for (int y = 1; y < height; ++y) {
+                        result.rows[y] = rows[y - 1];
+                    }
+                    break;
+                case Direction::NORTH:
+                    for (int y = 0; y + 1 < height; ++y) {
+                        result.rows[y] = rows[y + 1];
+                    }
+                    result.rows[height - 1] = rows[0];
+                    break;
+                default:
+                    result.rows = rows;
+                    break;
+            }
+            return result;
+        }
+
+        /** Every set cell together with its four cardinal neighbours. */
+        Bitboard dilated() const {
+            Bitboard result = shifted(Direction::NORTH);
+            result |= shifted(Direction::SOUTH);
+            result |= shifted(Direction::EAST);
+            result |= shifted(Direction::WEST);
+            result |= *this;
+            return result;
+        }
+
+        Bitboard& operator|=(const Bitboard& other) {
+            for (int y = 0; y < MAX_SIZE; ++y) {
+                rows[y] |= other.rows[y];
+            }
+            return *this;
+        }
+
+        Bitboard& operator&=(const Bitboard& other) {
+            for (int y = 0; y < MAX_SIZE; ++y) {
+                rows[y] &= other.rows[y];
+            }
+            return *this;
+        }
+
+        /** Clears every cell set in other. */
+        Bitboard& remove(const Bitboard& other) {
+            for (int y = 0; y < MAX_SIZE; ++y) {
+                rows[y] &= ~other.rows[y];
+            }
+            return *this;
+        }
+
+        bool any() const {
+            uint64_t bits = 0;
+            for (int y = 0; y < MAX_SIZE; ++y) {
+                bits |= rows[y];
+            }
+            return bits != 0;
+        }
+
+        int count() const {
+            int total = 0;
+            for (int y = 0; y < height; ++y) {
+                total += popcount64(rows[y]);
+            }
+            return total;
+        }
+    };
+
+    inline Bitboard operator|(Bitboard a, const Bitboard& b) {
+        return a |= b;
+    }
+
+    inline Bitboard operator&(Bitboard a, const Bitboard& b) {
+        return a &= b;
+    }
+
+    /** Who is where this frame, from the point of view of one player. */
+    struct OccupancyBoards {
+        Bitboard own_ships;
+        Bitboard enemy_ships;
+        Bitboard enemy_reach;    // enemy ships and every cell they can move to next turn
+        Bitboard own_structures; // shipyard and dropoffs
+
+        void build(int width, int height, const std::vector<std::shared_ptr<Player>>& players, PlayerId me) {
+            own_ships = enemy_ships = own_structures = Bitboard(width, height);
+            for (const auto& player : players) {
+                Bitboard& ships = player->id == me ? own_ships : enemy_ships;
+                for (const auto& ship_iterator : player->ships) {
+                    ships.set(ship_iterator.second->position);
+                }
+            }
+            const auto& mine = players[me];
+            own_structures.set(mine->shipyard->position);
+            for (const auto& dropoff_iterator : mine->dropoffs) {
+                own_structures.set(dropoff_iterator.second->position);
+            }
+            enemy_reach = enemy_ships.dilated();
+        }
+    };
+}
@@ -7,23 +7,6 @@
 
 using namespace hlt;
 
-namespace hlt {
-    namespace constants {
-        int MAX_HALITE;
-        int SHIP_COST;
-        int DROPOFF_COST;
-        int MAX_TURNS;
-        int EXTRACT_RATIO;
-        int MOVE_COST_RATIO;
-        bool INSPIRATION_ENABLED;
-        int INSPIRATION_RADIUS;
-        int INSPIRATION_SHIP_COUNT;
-        int INSPIRED_EXTRACT_RATIO;
-        double INSPIRED_BONUS_MULTIPLIER;
-        int INSPIRED_MOVE_COST_RATIO;
-    }
-}
-
 static std::string get_string(std::unordered_map<std::string, std::string>& map, const std::string& key) {
     auto it = map.find(key);
     if (it == map.end()) {
@@ -55,7 +38,7 @@ static bool get_bool(std::unordered_map<std::string, std::string>& map, const st
     exit(1);
 }
 
-void hlt::constants::populate_constants(const std::string& string_from_engine) {
+hlt::Constants hlt::Constants::parse(const std::string& string_from_engine) {
     std::string input;
     for (char c : string_from_engine) {
         switch (c) {
@@ -96,16 +79,18 @@ void hlt::constants::populate_constants(const std::string& string_from_engine) {
         constants_map[tokens[i]] = tokens[i+1];
     }
 
-    SHIP_COST = get_int(constants_map, "NEW_ENTITY_ENERGY_COST");
-    DROPOFF_COST = get_int(constants_map, "DROPOFF_COST");
-    MAX_HALITE = get_int(constants_map, "MAX_ENERGY");
-    MAX_TURNS = get_int(constants_map, "MAX_TURNS");
-    EXTRACT_RATIO = get_int(constants_map, "EXTRACT_RATIO");
-    MOVE_COST_RATIO = get_int(constants_map, "MOVE_COST_RATIO");
-    INSPIRATION_ENABLED = get_bool(constants_map, "INSPIRATION_ENABLED");
-    INSPIRATION_RADIUS = get_int(constants_map, "INSPIRATION_RADIUS");
-    INSPIRATION_SHIP_COUNT = get_int(constants_map, "INSPIRATION_SHIP_COUNT");
-    INSPIRED_EXTRACT_RATIO = get_int(constants_map, "INSPIRED_EXTRACT_RATIO");
-    INSPIRED_BONUS_MULTIPLIER = get_double(constants_map, "INSPIRED_BONUS_MULTIPLIER");
-    INSPIRED_MOVE_COST_RATIO = get_int(constants_map, "INSPIRED_MOVE_COST_RATIO");
+    Constants constants;
+    constants.SHIP_COST = get_int(constants_map, "NEW_ENTITY_ENERGY_COST");
+    constants.DROPOFF_COST = get_int(constants_map, "DROPOFF_COST");
+    constants.MAX_HALITE = get_int(constants_map, "MAX_ENERGY");
+    constants.MAX_TURNS = get_int(constants_map, "MAX_TURNS");
+    constants.EXTRACT_RATIO = get_int(constants_map, "EXTRACT_RATIO");
+    constants.MOVE_COST_RATIO = get_int(constants_map, "MOVE_COST_RATIO");
+    constants.INSPIRATION_ENABLED = get_bool(constants_map, "INSPIRATION_ENABLED");
+    constants.INSPIRATION_RADIUS = get_int(constants_map, "INSPIRATION_RADIUS");
+    constants.INSPIRATION_SHIP_COUNT = get_int(constants_map, "INSPIRATION_SHIP_COUNT");
+    constants.INSPIRED_EXTRACT_RATIO = get_int(constants_map, "INSPIRED_EXTRACT_RATIO");
+    constants.INSPIRED_BONUS_MULTIPLIER = get_double(constants_map, "INSPIRED_BONUS_MULTIPLIER");
+    constants.INSPIRED_MOVE_COST_RATIO = get_int(constants_map, "INSPIRED_MOVE_COST_RATIO");
+    return constants;
 }
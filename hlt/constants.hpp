@@ -7,33 +7,36 @@ namespace hlt {
      * The constants representing the game variation being played.
      * They come from game engine and changing them has no effect.
      * They are strictly informational.
+     * Each Game holds its own, so simulated games with different constants
+     * can run side by side, and any thread working on a game can read them.
      */
-    namespace constants {
-        void populate_constants(const std::string& string_from_engine);
+    struct Constants {
+        /** Parse the constants line the engine sends before anything else. */
+        static Constants parse(const std::string& string_from_engine);
 
         /** The maximum amount of halite a ship can carry. */
-        extern int MAX_HALITE;
+        int MAX_HALITE = 0;
         /** The cost to build a single ship. */
-        extern int SHIP_COST;
+        int SHIP_COST = 0;
         /** The cost to build a dropoff. */
-        extern int DROPOFF_COST;
+        int DROPOFF_COST = 0;
         /** The maximum number of turns a game can last. */
-        extern int MAX_TURNS;
+        int MAX_TURNS = 0;
         /** 1/EXTRACT_RATIO halite (rounded) is collected from a square per turn. */
-        extern int EXTRACT_RATIO;
+        int EXTRACT_RATIO = 0;
         /** 1/MOVE_COST_RATIO halite (rounded) is needed to move off a cell. */
-        extern int MOVE_COST_RATIO;
+        int MOVE_COST_RATIO = 0;
         /** Whether inspiration is enabled. */
-        extern bool INSPIRATION_ENABLED;
+        bool INSPIRATION_ENABLED = false;
         /** A ship is inspired if at least INSPIRATION_SHIP_COUNT opponent ships are within this Manhattan distance. */
-        extern int INSPIRATION_RADIUS;
+        int INSPIRATION_RADIUS = 0;
         /** A ship is inspired if at least this many opponent ships are within INSPIRATION_RADIUS distance. */
-        extern int INSPIRATION_SHIP_COUNT;
+        int INSPIRATION_SHIP_COUNT = 0;
         /** An inspired ship mines 1/X halite from a cell per turn instead. */
-        extern int INSPIRED_EXTRACT_RATIO;
+        int INSPIRED_EXTRACT_RATIO = 0;
         /** An inspired ship that removes Y halite from a cell collects X*Y additional halite. */
-        extern double INSPIRED_BONUS_MULTIPLIER;
+        double INSPIRED_BONUS_MULTIPLIER = 0;
         /** An inspired ship instead spends 1/X% halite to move. */
-        extern int INSPIRED_MOVE_COST_RATIO;
-    }
+        int INSPIRED_MOVE_COST_RATIO = 0;
+    };
 }
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "game_map.hpp"
+
+#include <vector>
+
+namespace hlt {
+    /**
+     * Toroidal Manhattan distance from every cell to the closest of a set of source cells,
+     * such as a player's shipyard and dropoffs. Sources can only be added, which keeps
+     * an update O(cells) per new source instead of O(cells * sources) per query.
+     */
+    struct DistanceField {
+        std::vector<int> distance; // one entry per map cell index
+        int source_count = 0;
+
+        void add_source(GameMap& map, const Position& source) {
+            if (distance.empty()) {
+                distance.assign((size_t)map.width * map.height, map.width + map.height);
+            }
+            const Position normalized = map.normalize(source);
+            for (int y = 0; y < map.height; ++y) {
+                const int dy = map.delta_y[y - normalized.y + 3 * map.height];
+                int* row = &distance[y * map.width];
+                for (int x = 0; x < map.width; ++x) {
+                    const int d = dy + map.delta_x[x - normalized.x + 3 * map.width];
+                    if (d < row[x]) {
+                        row[x] = d;
+                    }
+                }
+            }
+            ++source_count;
+        }
+
+        int at(GameMap& map, const Position& position) const {
+            return distance[map.index(position)];
+        }
+    };
+}
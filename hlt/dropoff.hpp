@@ -1,6 +1,7 @@
 #pragma once
 
 #include "entity.hpp"
+#include "input.hpp"
 
 #include <memory>
 
@@ -8,6 +9,6 @@ namespace hlt {
     struct Dropoff : Entity {
         using Entity::Entity;
 
-        static std::shared_ptr<Dropoff> _generate(PlayerId player_id);
+        static Dropoff _generate(Input& input, PlayerId player_id);
     };
 }
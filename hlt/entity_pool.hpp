@@ -0,0 +1,90 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <deque>
+#include <vector>
+
+namespace hlt {
+    /**
+     * Per-game storage for entities keyed by EntityId.
+     * Records live for the whole game and are updated in place every frame,
+     * so handing out plain pointers to them is safe until the entity dies.
+     * Slots of dead entities are recycled for new ones.
+     */
+    template <typename T>
+    class EntityPool {
+    public:
+        /** The entity with this id, or nullptr if it is not alive. */
+        T* get(EntityId id) const {
+            if (id < 0 || static_cast<size_t>(id) >= by_id.size()) {
+                return nullptr;
+            }
+            return by_id[id];
+        }
+
+        /** Stores value as the entity's current state and marks it seen this frame. */
+        T* update(const T& value) {
+            const EntityId id = value.id;
+            if (static_cast<size_t>(id) >= by_id.size()) {
+                by_id.resize(id + 1, nullptr);
+                seen_frame.resize(id + 1, 0);
+            }
+            seen_frame[id] = frame;
+
+            T* slot = by_id[id];
+            if (slot) {
+                *slot = value;
+                return slot;
+            }
+            if (!free_slots.empty()) {
+                slot = free_slots.back();
+                free_slots.pop_back();
+                *slot = value;
+            } else {
+                // a deque never moves its elements, so pointers to slots stay valid
+                storage.push_back(value);
+                slot = &storage.back();
+            }
+            by_id[id] = slot;
+            return slot;
+        }
+
+        /**
+         * Makes room for this many entities alive at once and for ids below max_ids,
+         * so that updates allocate nothing until the game goes past either.
+         * blank fills the spare slots until entities take them.
+         */
+        void reserve(size_t live, size_t max_ids, const T& blank) {
+            while (storage.size() < live) {
+                storage.push_back(blank);
+                free_slots.push_back(&storage.back());
+            }
+            free_slots.reserve(storage.size());
+            by_id.reserve(max_ids);
+            seen_frame.reserve(max_ids);
+        }
+
+        /** Starts a new frame; entities not updated until the next one count as unseen. */
+        void begin_frame() {
+            ++frame;
+        }
+
+        bool seen_this_frame(EntityId id) const {
+            return seen_frame[id] == frame;
+        }
+
+        /** Frees the entity's slot for reuse. Pointers to it must no longer be used. */
+        void release(EntityId id) {
+            free_slots.push_back(by_id[id]);
+            by_id[id] = nullptr;
+        }
+
+    private:
+        std::deque<T> storage;
+        std::vector<T*> free_slots;
+        std::vector<T*> by_id;
+        std::vector<unsigned int> seen_frame;
+        unsigned int frame = 0;
+    };
+}
@@ -1,24 +1,36 @@
 #include "game.hpp"
-#include "input.hpp"
 
-#include <sstream>
+hlt::Game::Game() : Game(Input()) {}
 
-hlt::Game::Game() : turn_number(0) {
+hlt::Game::Game(Input input) : turn_number(0), input(std::move(input)) {
     std::ios_base::sync_with_stdio(false);
 
-    hlt::constants::populate_constants(hlt::get_string());
+    constants = Constants::parse(this->input.next_line());
 
-    int num_players;
-    std::stringstream input(get_string());
-    input >> num_players >> my_id;
+    const int num_players = this->input.next_int();
+    my_id = this->input.next_int();
 
     log::open(my_id);
 
     for (int i = 0; i < num_players; ++i) {
-        players.push_back(Player::_generate());
+        players.push_back(Player::_generate(this->input));
     }
     me = players[my_id];
-    game_map = GameMap::_generate();
+    game_map = GameMap::_generate(this->input);
+    _reserve_entities();
+}
+
+hlt::Game::Game(const Constants& constants, PlayerId my_id, std::vector<std::shared_ptr<Player>> players,
+                std::shared_ptr<GameMap> game_map) :
+    turn_number(0),
+    constants(constants),
+    my_id(my_id),
+    players(std::move(players)),
+    game_map(std::move(game_map)),
+    input(Input::from_string(""))
+{
+    me = this->players[my_id];
+    _reserve_entities();
 }
 
 void hlt::Game::ready(const std::string& name) {
@@ -26,34 +38,61 @@ void hlt::Game::ready(const std::string& name) {
 }
 
 void hlt::Game::update_frame() {
-    hlt::get_sstream() >> turn_number;
-    log::log("=============== TURN " + std::to_string(turn_number) + " ================");
+    // the engine closing the connection between turns is the normal end of
+    // the game; running out anywhere else is an error (see Input)
+    if (input.at_end()) {
+        log::log("Input connection from server closed. Exiting...");
+        exit(0);
+    }
+    turn_number = input.next_int();
+    // short enough to stay in the string's own storage, so it costs no allocation
+    LOG_INFO("TURN " + std::to_string(turn_number));
 
     for (size_t i = 0; i < players.size(); ++i) {
-        PlayerId current_player_id;
-        int num_ships;
-        int num_dropoffs;
-        Halite halite;
-        hlt::get_sstream() >> current_player_id >> num_ships >> num_dropoffs >> halite;
+        const PlayerId current_player_id = input.next_int();
+        const int num_ships = input.next_int();
+        const int num_dropoffs = input.next_int();
+        const Halite halite = input.next_int();
 
-        players[current_player_id]->_update(num_ships, num_dropoffs, halite);
+        players[current_player_id]->_update(input, ship_pool, dropoff_pool, num_ships, num_dropoffs, halite);
     }
 
-    game_map->_update();
+    game_map->_update(input);
+    _finish_frame();
+}
+
+void hlt::Game::_reserve_entities() {
+    const size_t cells = (size_t)game_map->width * game_map->height;
+    ship_pool.reserve(cells, cells, Ship(-1, -1, 0, 0, 0));
+    dropoff_pool.reserve(cells, cells, Dropoff(-1, -1, 0, 0));
+    for (const auto& player : players) {
+        player->_reserve(cells);
+    }
+}
 
+void hlt::Game::_finish_frame() {
     for (const auto& player : players) {
         for (auto& ship_iterator : player->ships) {
             auto ship = ship_iterator.second;
-            game_map->at(ship)->mark_unsafe(ship);
+            game_map->at(ship).mark_unsafe(ship);
         }
 
-        game_map->at(player->shipyard)->structure = player->shipyard;
+        game_map->structure_owner[game_map->index(player->shipyard->position)] = player->id;
+
+        if (player->home_distance.source_count == 0) {
+            player->home_distance.add_source(*game_map, player->shipyard->position);
+        }
+        for (Dropoff* dropoff : player->new_dropoffs) {
+            player->home_distance.add_source(*game_map, dropoff->position);
+        }
 
         for (auto& dropoff_iterator : player->dropoffs) {
             auto dropoff = dropoff_iterator.second;
-            game_map->at(dropoff)->structure = dropoff;
+            game_map->structure_owner[game_map->index(dropoff->position)] = player->id;
         }
     }
+
+    boards.build(game_map->width, game_map->height, players, my_id);
 }
 
 bool hlt::Game::end_turn(const std::vector<hlt::Command>& commands) {
@@ -61,5 +100,6 @@ bool hlt::Game::end_turn(const std::vector<hlt::Command>& commands) {
         std::cout << command << ' ';
     }
     std::cout << std::endl;
+    log::flush();
     return std::cout.good();
 }
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "game_map.hpp"
+#include "bitboard.hpp"
 #include "player.hpp"
 #include "types.hpp"
+#include "input.hpp"
+#include "constants.hpp"
 
 #include <vector>
 #include <iostream>
@@ -10,14 +13,34 @@
 namespace hlt {
     struct Game {
         int turn_number;
+        Constants constants;
         PlayerId my_id;
         std::vector<std::shared_ptr<Player>> players;
         std::shared_ptr<Player> me;
         std::shared_ptr<GameMap> game_map;
+        OccupancyBoards boards; // seen from my_id, rebuilt every frame
+        EntityPool<Ship> ship_pool;
+        EntityPool<Dropoff> dropoff_pool;
+        Input input;
 
         Game();
+        explicit Game(Input input);
+        /**
+         * A game whose frames are filled in directly rather than read from the engine,
+         * for running the bot in-process.
+         */
+        Game(const Constants& constants, PlayerId my_id, std::vector<std::shared_ptr<Player>> players,
+             std::shared_ptr<GameMap> game_map);
         void ready(const std::string& name);
         void update_frame();
         bool end_turn(const std::vector<Command>& commands);
+
+        /**
+         * Sizes the entity storage for the map: at most one ship ends a turn on
+         * each cell, so a game never has more ships alive than the map has cells.
+         */
+        void _reserve_entities();
+        /** Derives the per-frame map state once all players and the map have been updated. */
+        void _finish_frame();
     };
 }
@@ -1,42 +1,175 @@
 #include "game_map.hpp"
-#include "input.hpp"
 
-void hlt::GameMap::_update() {
+#include <algorithm>
+#include <cmath>
+
+void hlt::GameMap::_clear_entities() {
+    std::fill(occupant_ship_id.begin(), occupant_ship_id.end(), -1);
+    std::fill(structure_owner.begin(), structure_owner.end(), -1);
+}
+
+void hlt::GameMap::_update(hlt::Input& input) {
+    _clear_entities();
+    changed_cells.clear();
+
+    const int cell_count = input.next_int();
+
+    for (int i = 0; i < cell_count; ++i) {
+        const int x = input.next_int();
+        const int y = input.next_int();
+        const Halite value = input.next_int();
+        if (this->halite[y * width + x] != value) {
+            this->halite[y * width + x] = value;
+            changed_cells.push_back(y * width + x);
+        }
+    }
+
+    _build_halite_sums();
+    ++update_count;
+}
+
+void hlt::GameMap::_update(const std::vector<Halite>& cell_halite) {
+    _clear_entities();
+    changed_cells.clear();
+    for (size_t i = 0; i < halite.size(); ++i) {
+        if (halite[i] != cell_halite[i]) {
+            changed_cells.push_back((int)i);
+        }
+    }
+    halite = cell_halite;
+    _build_halite_sums();
+    ++update_count;
+}
+
+void hlt::GameMap::_build_halite_sums() {
+    const int stride = width + 1;
+    halite_sums.assign((size_t)stride * (height + 1), 0);
     for (int y = 0; y < height; ++y) {
+        long long row_sum = 0;
         for (int x = 0; x < width; ++x) {
-            cells[y][x].ship.reset();
+            row_sum += halite[y * width + x];
+            halite_sums[(y + 1) * stride + x + 1] = halite_sums[y * stride + x + 1] + row_sum;
         }
     }
+}
 
-    int update_count;
-    hlt::get_sstream() >> update_count;
+// Sum over the half-open cell range [x0, x1) x [y0, y1), all within the map.
+static long long sum_range(const std::vector<long long>& sums, int stride, int x0, int y0, int x1, int y1) {
+    return sums[y1 * stride + x1] - sums[y0 * stride + x1] - sums[y1 * stride + x0] + sums[y0 * stride + x0];
+}
+
+long long hlt::GameMap::rectangle_halite(const Position& center, int radius_x, int radius_y) {
+    const Position normalized = normalize(center);
+    const int stride = width + 1;
 
-    for (int i = 0; i < update_count; ++i) {
-        int x;
-        int y;
-        int halite;
-        hlt::get_sstream() >> x >> y >> halite;
-        cells[y][x].halite = halite;
+    // Split each axis into at most two in-map ranges.
+    int xs[2][2];
+    int x_ranges = 1;
+    if (2 * radius_x + 1 >= width) {
+        xs[0][0] = 0;
+        xs[0][1] = width;
+    } else {
+        const int x0 = normalized.x - radius_x;
+        const int x1 = normalized.x + radius_x + 1;
+        if (x0 < 0) {
+            xs[0][0] = 0; xs[0][1] = x1;
+            xs[1][0] = x0 + width; xs[1][1] = width;
+            x_ranges = 2;
+        } else if (x1 > width) {
+            xs[0][0] = x0; xs[0][1] = width;
+            xs[1][0] = 0; xs[1][1] = x1 - width;
+            x_ranges = 2;
+        } else {
+            xs[0][0] = x0; xs[0][1] = x1;
+        }
     }
+
+    int ys[2][2];
+    int y_ranges = 1;
+    if (2 * radius_y + 1 >= height) {
+        ys[0][0] = 0;
+        ys[0][1] = height;
+    } else {
+        const int y0 = normalized.y - radius_y;
+        const int y1 = normalized.y + radius_y + 1;
+        if (y0 < 0) {
+            ys[0][0] = 0; ys[0][1] = y1;
+            ys[1][0] = y0 + height; ys[1][1] = height;
+            y_ranges = 2;
+        } else if (y1 > height) {
+            ys[0][0] = y0; ys[0][1] = height;
+            ys[1][0] = 0; ys[1][1] = y1 - height;
+            y_ranges = 2;
+        } else {
+            ys[0][0] = y0; ys[0][1] = y1;
+        }
+    }
+
+    long long total = 0;
+    for (int i = 0; i < x_ranges; ++i) {
+        for (int j = 0; j < y_ranges; ++j) {
+            total += sum_range(halite_sums, stride, xs[i][0], ys[j][0], xs[i][1], ys[j][1]);
+        }
+    }
+    return total;
 }
 
-std::shared_ptr<hlt::GameMap> hlt::GameMap::_generate() {
-    std::shared_ptr<hlt::GameMap> map = std::make_unique<GameMap>();
+long long hlt::GameMap::diamond_halite(const Position& center, int radius) {
+    const long long diamond_cells = 2LL * radius * radius + 2LL * radius + 1;
+    const int half_side = (int) std::lround((std::sqrt((double) diamond_cells) - 1) / 2);
+    const long long square_cells = (2LL * half_side + 1) * (2LL * half_side + 1);
+    return rectangle_halite(center, half_side, half_side) * diamond_cells / square_cells;
+}
 
-    hlt::get_sstream() >> map->width >> map->height;
+void hlt::GameMap::_build_tables() {
+    wrap_x.resize(3 * width);
+    for (int x = -width; x < 2 * width; ++x) {
+        wrap_x[x + width] = wrap_coordinate(x, width);
+    }
+    wrap_y.resize(3 * height);
+    for (int y = -height; y < 2 * height; ++y) {
+        wrap_y[y + height] = wrap_coordinate(y, height);
+    }
 
-    map->cells.resize((size_t)map->height);
-    for (int y = 0; y < map->height; ++y) {
-        auto in = hlt::get_sstream();
+    delta_x.resize(6 * width);
+    for (int dx = -3 * width; dx < 3 * width; ++dx) {
+        delta_x[dx + 3 * width] = toroidal_delta(dx, width);
+    }
+    delta_y.resize(6 * height);
+    for (int dy = -3 * height; dy < 3 * height; ++dy) {
+        delta_y[dy + 3 * height] = toroidal_delta(dy, height);
+    }
+}
 
-        map->cells[y].reserve((size_t)map->width);
-        for (int x = 0; x < map->width; ++x) {
-            hlt::Halite halite;
-            in >> halite;
+std::shared_ptr<hlt::GameMap> hlt::GameMap::_generate(hlt::Input& input) {
+    const int width = input.next_int();
+    const int height = input.next_int();
 
-            map->cells[y].push_back(MapCell(x, y, halite));
-        }
+    const size_t cell_count = (size_t)width * (size_t)height;
+    std::vector<Halite> cell_halite;
+    cell_halite.reserve(cell_count);
+    for (size_t i = 0; i < cell_count; ++i) {
+        cell_halite.push_back(input.next_int());
     }
+    return _generate(width, height, std::move(cell_halite));
+}
+
+std::shared_ptr<hlt::GameMap> hlt::GameMap::_generate(int width, int height, std::vector<Halite> cell_halite) {
+    std::shared_ptr<hlt::GameMap> map = std::make_unique<GameMap>();
+
+    map->width = width;
+    map->height = height;
+
+    const size_t cell_count = (size_t)width * (size_t)height;
+    map->halite = std::move(cell_halite);
+    map->occupant_ship_id.assign(cell_count, -1);
+    map->structure_owner.assign(cell_count, -1);
+    // no more cells than the map has can change, and a game rarely hands out
+    // more ship ids than that, so neither grows turn by turn
+    map->changed_cells.reserve(cell_count);
+    map->ships_by_id.reserve(cell_count);
+    map->_build_tables();
+    map->_build_halite_sums();
 
     return map;
 }
@@ -2,33 +2,100 @@
 
 #include "types.hpp"
 #include "map_cell.hpp"
+#include "input.hpp"
 
 #include <vector>
 
 namespace hlt {
+    /** Wraps a coordinate onto an axis of the given size. */
+    constexpr int wrap_coordinate(int coordinate, int size) {
+        return ((coordinate % size) + size) % size;
+    }
+
+    /** Toroidal distance along an axis of the given size between coordinates delta apart. */
+    constexpr int toroidal_delta(int delta, int size) {
+        const int wrapped = wrap_coordinate(delta, size);
+        return wrapped < size - wrapped ? wrapped : size - wrapped;
+    }
+
     struct GameMap {
         int width;
         int height;
-        std::vector<std::vector<MapCell>> cells;
 
-        MapCell* at(const Position& position) {
+        // Cell storage, one entry per cell at index y * width + x.
+        std::vector<Halite> halite;
+        std::vector<EntityId> occupant_ship_id; // -1 if there is no ship on the cell
+        std::vector<PlayerId> structure_owner;  // -1 if there is no shipyard or dropoff on the cell
+        std::vector<Ship*> ships_by_id; // resolves occupant_ship_id to a ship; only valid for occupied cells
+
+        // Lookup tables replacing the modulo arithmetic for coordinates within one map
+        // size off the board (see _build_tables). wrap_x[x + width] normalizes x, and
+        // delta_x[dx + 3 * width] is the toroidal distance of a difference dx.
+        std::vector<int> wrap_x;
+        std::vector<int> wrap_y;
+        std::vector<int> delta_x;
+        std::vector<int> delta_y;
+
+        // Summed-area table of halite: halite_sums[(y + 1) * (width + 1) + x + 1] is the
+        // total halite of the cells with coordinates at most (x, y). Rebuilt with every
+        // map update, it answers any window total in O(1) (see rectangle_halite).
+        std::vector<long long> halite_sums;
+
+        // Cells whose halite changed in the latest update, and how many updates there
+        // have been, so per-turn state can follow the map by its changes alone.
+        std::vector<int> changed_cells;
+        int update_count = 0;
+
+        long long total_halite() const {
+            return halite_sums.back();
+        }
+
+        /**
+         * Total halite of the cells within radius_x columns and radius_y rows of center,
+         * wrapping around the edges. A window wider than the map covers each cell once.
+         */
+        long long rectangle_halite(const Position& center, int radius_x, int radius_y);
+
+        /**
+         * Approximate total halite of the cells within Manhattan distance radius of center,
+         * from the square window with the same number of cells as the diamond.
+         */
+        long long diamond_halite(const Position& center, int radius);
+
+        int index(const Position& position) {
+            Position normalized = normalize(position);
+            return normalized.y * width + normalized.x;
+        }
+
+        Position position(int cell_index) const {
+            return Position(cell_index % width, cell_index / width);
+        }
+
+        MapCell at(const Position& position) {
             Position normalized = normalize(position);
-            return &cells[normalized.y][normalized.x];
+            const int cell_index = normalized.y * width + normalized.x;
+            return MapCell(this, cell_index, normalized, halite[cell_index]);
         }
 
-        MapCell* at(const Entity& entity) {
+        MapCell at(const Entity& entity) {
             return at(entity.position);
         }
 
-        MapCell* at(const Entity* entity) {
+        MapCell at(const Entity* entity) {
             return at(entity->position);
         }
 
-        MapCell* at(const std::shared_ptr<Entity>& entity) {
+        MapCell at(const std::shared_ptr<Entity>& entity) {
             return at(entity->position);
         }
 
         int calculate_distance(const Position& source, const Position& target) {
+            const unsigned int table_dx = source.x - target.x + 3 * width;
+            const unsigned int table_dy = source.y - target.y + 3 * height;
+            if (table_dx < delta_x.size() && table_dy < delta_y.size()) {
+                return delta_x[table_dx] + delta_y[table_dy];
+            }
+
             const auto& normalized_source = normalize(source);
             const auto& normalized_target = normalize(target);
 
@@ -42,16 +109,31 @@ namespace hlt {
         }
 
         Position normalize(const Position& position) {
-            const int x = ((position.x % width) + width) % width;
-            const int y = ((position.y % height) + height) % height;
-            return { x, y };
+            const unsigned int table_x = position.x + width;
+            const unsigned int table_y = position.y + height;
+            if (table_x < wrap_x.size() && table_y < wrap_y.size()) {
+                return { wrap_x[table_x], wrap_y[table_y] };
+            }
+            return { wrap_coordinate(position.x, width), wrap_coordinate(position.y, height) };
         }
 
         std::vector<Direction> get_unsafe_moves(const Position& source, const Position& destination) {
+            std::vector<Direction> possible_moves;
+            add_unsafe_moves(source, destination, possible_moves);
+            return possible_moves;
+        }
+
+        /**
+         * Like get_unsafe_moves, adding the moves to the end of possible_moves
+         * instead of returning a new vector, so the caller picks the container.
+         */
+        template <typename Moves>
+        void add_unsafe_moves(const Position& source, const Position& destination, Moves& possible_moves) {
             if (source == destination) {
-                return { Direction::STILL };
+                possible_moves.push_back(Direction::STILL);
+                return;
             }
-            
+
             const auto& normalized_source = normalize(source);
             const auto& normalized_destination = normalize(destination);
 
@@ -60,8 +142,6 @@ namespace hlt {
             const int wrapped_dx = width - dx;
             const int wrapped_dy = height - dy;
 
-            std::vector<Direction> possible_moves;
-
             if (normalized_source.x < normalized_destination.x) {
                 possible_moves.push_back(dx > wrapped_dx ? Direction::WEST : Direction::EAST);
             } else if (normalized_source.x > normalized_destination.x) {
@@ -73,16 +153,14 @@ namespace hlt {
             } else if (normalized_source.y > normalized_destination.y) {
                 possible_moves.push_back(dy < wrapped_dy ? Direction::NORTH : Direction::SOUTH);
             }
-
-            return possible_moves;
         }
 
-        Direction naive_navigate(std::shared_ptr<Ship> ship, const Position& destination) {
+        Direction naive_navigate(Ship* ship, const Position& destination) {
             // get_unsafe_moves normalizes for us
             for (auto direction : get_unsafe_moves(ship->position, destination)) {
                 Position target_pos = ship->position.directional_offset(direction);
-                if (!at(target_pos)->is_occupied()) {
-                    at(target_pos)->mark_unsafe(ship);
+                if (!at(target_pos).is_occupied()) {
+                    at(target_pos).mark_unsafe(ship);
                     return direction;
                 }
             }
@@ -94,12 +172,50 @@ namespace hlt {
             return normalize(pos.directional_offset(dir));
         }
 
-        bool can_move(std::shared_ptr<Ship> ship) {
-            // return whether ship has halite > gameMap->at(this)->halite / 10;
-            return ship->halite * 10 >= at(ship)->halite;
+        bool can_move(const Ship* ship) {
+            // return whether ship has halite > gameMap->at(this).halite / 10;
+            return ship->halite * 10 >= at(ship).halite;
         }
 
-        void _update();
-        static std::shared_ptr<GameMap> _generate();
+        void _build_tables();
+        void _build_halite_sums();
+        void _clear_entities();
+        void _update(Input& input);
+        /** Like _update, with the halite of every cell given directly. */
+        void _update(const std::vector<Halite>& cell_halite);
+        static std::shared_ptr<GameMap> _generate(Input& input);
+        static std::shared_ptr<GameMap> _generate(int width, int height, std::vector<Halite> cell_halite);
     };
+
+    inline bool MapCell::is_empty() const {
+        return !is_occupied() && !has_structure();
+    }
+
+    inline bool MapCell::is_occupied() const {
+        return map->occupant_ship_id[index] != -1;
+    }
+
+    inline bool MapCell::has_structure() const {
+        return map->structure_owner[index] != -1;
+    }
+
+    inline Ship* MapCell::ship() const {
+        const EntityId ship_id = map->occupant_ship_id[index];
+        if (ship_id == -1) {
+            return nullptr;
+        }
+        return map->ships_by_id[ship_id];
+    }
+
+    inline PlayerId MapCell::structure_owner() const {
+        return map->structure_owner[index];
+    }
+
+    inline void MapCell::mark_unsafe(Ship* ship) {
+        if (static_cast<size_t>(ship->id) >= map->ships_by_id.size()) {
+            map->ships_by_id.resize(ship->id + 1, nullptr);
+        }
+        map->ships_by_id[ship->id] = ship;
+        map->occupant_ship_id[index] = ship->id;
+    }
 }
@@ -0,0 +1,136 @@
+#include "input.hpp"
+#include "log.hpp"
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <io.h>
+#define read _read
+#else
+#include <unistd.h>
+#endif
+
+static const size_t BUFFER_SIZE = 1 << 16;
+
+hlt::Input::Input(int fd) :
+    fd(fd),
+    buffer(BUFFER_SIZE),
+    position(0),
+    end(0),
+    consumed(0)
+{}
+
+hlt::Input hlt::Input::from_string(std::string data) {
+    Input input(-1);
+    input.buffer.assign(data.begin(), data.end());
+    input.end = input.buffer.size();
+    return input;
+}
+
+bool hlt::Input::refill() {
+    if (fd < 0) {
+        return false;
+    }
+    consumed += end;
+    position = 0;
+    end = 0;
+    for (;;) {
+        auto count = read(fd, buffer.data(), (unsigned int) buffer.size());
+        if (count > 0) {
+            end = (size_t) count;
+            return true;
+        }
+        if (count == 0) {
+            return false;
+        }
+        // count < 0: interrupted reads are retried, anything else is a closed connection
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+void hlt::Input::fail(const std::string& problem) {
+    LOG_ERROR("Error: input: " + problem + " (at byte " + std::to_string(consumed + position) + ")");
+    exit(1);
+}
+
+static bool is_whitespace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+bool hlt::Input::skip_whitespace() {
+    for (;;) {
+        if (position == end && !refill()) {
+            return false;
+        }
+        if (!is_whitespace(buffer[position])) {
+            return true;
+        }
+        ++position;
+    }
+}
+
+int hlt::Input::next_int() {
+    if (!skip_whitespace()) {
+        fail("the input ended in the middle of a frame");
+    }
+
+    bool negative = false;
+    if (buffer[position] == '-') {
+        negative = true;
+        ++position;
+    }
+
+    long long value = 0;
+    int digits = 0;
+    for (;;) {
+        if (position == end && !refill()) {
+            break;
+        }
+        const char c = buffer[position];
+        if (c < '0' || c > '9') {
+            if (!is_whitespace(c)) {
+                fail(std::string("expected an integer, found '") + c + "'");
+            }
+            break;
+        }
+        value = value * 10 + (c - '0');
+        if (value > INT_MAX) {
+            fail("integer out of range");
+        }
+        ++digits;
+        ++position;
+    }
+    if (digits == 0) {
+        fail("expected an integer");
+    }
+    return negative ? -int(value) : int(value);
+}
+
+std::string hlt::Input::next_line() {
+    if (!skip_whitespace()) {
+        fail("the input ended before an expected line");
+    }
+
+    std::string line;
+    for (;;) {
+        if (position == end && !refill()) {
+            break;
+        }
+        const char c = buffer[position++];
+        if (c == '\n') {
+            break;
+        }
+        if (c != '\r') {
+            line.push_back(c);
+        }
+    }
+    return line;
+}
+
+bool hlt::Input::at_end() {
+    return !skip_whitespace();
+}
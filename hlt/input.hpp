@@ -1,23 +1,53 @@
 #pragma once
 
-#include "log.hpp"
-
 #include <string>
-#include <iostream>
-#include <sstream>
+#include <vector>
 
 namespace hlt {
-    static std::string get_string() {
-        std::string result;
-        std::getline(std::cin, result);
-        if (!std::cin.good()) {
-            hlt::log::log("Input connection from server closed. Exiting...");
-            exit(0);
-        }
-        return result;
-    }
-
-    static std::stringstream get_sstream() {
-        return std::stringstream(get_string());
-    }
+    /**
+     * Buffered reader for the engine protocol.
+     * Input is pulled in large read() chunks into one reusable buffer and
+     * integers are scanned straight out of it, so parsing a frame does not
+     * allocate or build any stream objects.
+     * Malformed or truncated input is logged as an error and exits the bot
+     * with status 1; callers check at_end where the input may cleanly stop.
+     */
+    class Input {
+    public:
+        /** Reads from a file descriptor, stdin by default. */
+        explicit Input(int fd = 0);
+
+        /** Reads from recorded engine input instead of a file descriptor. */
+        static Input from_string(std::string data);
+
+        Input(Input&&) = default;
+        Input& operator=(Input&&) = default;
+        Input(const Input&) = delete;
+        Input& operator=(const Input&) = delete;
+
+        /** Reads the next (optionally negative) integer, skipping whitespace. */
+        int next_int();
+
+        /** Reads the next non-empty line, without the line terminator. */
+        std::string next_line();
+
+        /** Whether there is nothing but whitespace left. May block on a file descriptor. */
+        bool at_end();
+
+    private:
+        /** Pulls more data into the buffer. Returns false once the source is exhausted. */
+        bool refill();
+
+        /** Skips whitespace. Returns false if the source is exhausted. */
+        bool skip_whitespace();
+
+        /** Logs what is wrong with the input and exits the bot. */
+        [[noreturn]] void fail(const std::string& problem);
+
+        int fd;
+        std::vector<char> buffer;
+        size_t position;
+        size_t end;
+        size_t consumed; // bytes before the buffer, for error messages
+    };
 }
@@ -1,17 +1,172 @@
 #include "log.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <thread>
 #include <vector>
-#include <chrono>
 
-static std::ofstream log_file;
-static std::vector<std::string> log_buffer;
-static bool has_opened = false;
+namespace {
+    /**
+     * Writes log messages to a file on a background thread.
+     * Callers hand messages over through a bounded lock-free ring (one sequence
+     * number per slot, so any number of threads can log at once), and the writer
+     * thread is the only one that touches the file until it is stopped.
+     */
+    class AsyncWriter {
+    public:
+        explicit AsyncWriter(const std::string& filename) :
+            file(filename, std::ios::trunc | std::ios::out), slots(RING_SIZE) {
+            for (size_t i = 0; i < RING_SIZE; ++i) {
+                slots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+            worker = std::thread([this] { run(); });
+        }
+
+        void push(std::string message) {
+            if (stopped.load(std::memory_order_acquire)) {
+                // the writer thread is gone (we are exiting), write directly
+                file << message << '\n';
+                file.flush();
+                return;
+            }
+            size_t position = enqueue_position.load(std::memory_order_relaxed);
+            for (;;) {
+                Slot& slot = slots[position & (RING_SIZE - 1)];
+                const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+                if (difference == 0) {
+                    if (enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        slot.message = std::move(message);
+                        slot.sequence.store(position + 1, std::memory_order_release);
+                        return;
+                    }
+                } else if (difference < 0) {
+                    // the ring is full, give the writer a chance to catch up
+                    std::this_thread::yield();
+                    position = enqueue_position.load(std::memory_order_relaxed);
+                } else {
+                    position = enqueue_position.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        void flush() {
+            if (stopped.load(std::memory_order_acquire)) {
+                return;
+            }
+            const size_t target = enqueue_position.load(std::memory_order_acquire);
+            std::unique_lock<std::mutex> lock(mutex);
+            flush_target = std::max(flush_target, target);
+            wake.notify_one();
+            flushed.wait(lock, [&] { return flushed_position >= target; });
+        }
+
+        void stop() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_one();
+            worker.join();
+            stopped.store(true, std::memory_order_release);
+        }
+
+    private:
+        static const size_t RING_SIZE = 4096; // a power of two
+
+        struct Slot {
+            std::atomic<size_t> sequence;
+            std::string message;
+        };
+
+        bool pop(std::string& message) {
+            Slot& slot = slots[dequeue_position & (RING_SIZE - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != dequeue_position + 1) {
+                return false;
+            }
+            message = std::move(slot.message);
+            slot.message.clear();
+            slot.sequence.store(dequeue_position + RING_SIZE, std::memory_order_release);
+            ++dequeue_position;
+            return true;
+        }
+
+        void run() {
+            std::string message;
+            for (;;) {
+                bool wrote = false;
+                while (pop(message)) {
+                    file << message << '\n';
+                    wrote = true;
+                }
+
+                std::unique_lock<std::mutex> lock(mutex);
+                if (flush_target > flushed_position) {
+                    if (dequeue_position < flush_target) {
+                        // a logging thread is still filling in one of the slots
+                        continue;
+                    }
+                    file.flush();
+                    flushed_position = dequeue_position;
+                    flushed.notify_all();
+                }
+                if (stopping && dequeue_position == enqueue_position.load(std::memory_order_acquire)) {
+                    file.flush();
+                    return;
+                }
+                if (!wrote) {
+                    wake.wait_for(lock, std::chrono::milliseconds(2));
+                }
+            }
+        }
+
+        std::ofstream file;
+        std::vector<Slot> slots;
+        std::atomic<size_t> enqueue_position{0};
+        size_t dequeue_position = 0; // only used by the writer thread
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable flushed;
+        size_t flush_target = 0;
+        size_t flushed_position = 0;
+        bool stopping = false;
+        std::atomic<bool> stopped{false};
+
+        std::thread worker;
+    };
+}
+
+// Messages kept until the log is opened. Past this many the rest are only
+// counted, so tools that never open the log do not grow it game after game.
+static const size_t LOG_BUFFER_LIMIT = 1024;
+
+// Never destroyed: messages may still be logged while statics are torn down.
+// writer is set before has_opened, and only read once has_opened is seen.
+static AsyncWriter* writer = nullptr;
+static std::atomic<bool> has_opened{false};
+// guarded by log_buffer_mutex, like the rest; reserved up front, so logging
+// before the log is opened does not allocate in the middle of a turn either
+static std::vector<std::string> log_buffer = [] {
+    std::vector<std::string> buffer;
+    buffer.reserve(LOG_BUFFER_LIMIT);
+    return buffer;
+}();
+static size_t dropped_messages = 0;
 static bool has_atexit = false;
+static std::mutex log_buffer_mutex;
+static std::atomic<int> current_level{HLT_LOG_MIN_LEVEL};
 
 void dump_buffer_at_exit() {
-    if (has_opened) {
+    std::lock_guard<std::mutex> lock(log_buffer_mutex);
+    if (has_opened.load(std::memory_order_acquire)) {
         return;
     }
 
@@ -19,34 +174,83 @@ void dump_buffer_at_exit() {
     std::string filename = "bot-unknown-" + std::to_string(now_in_nanos) + ".log";
     std::ofstream file(filename, std::ios::trunc | std::ios::out);
     for (const std::string& message : log_buffer) {
-        file << message << std::endl;
+        file << message << '\n';
+    }
+    if (dropped_messages > 0) {
+        file << dropped_messages << " more messages were dropped\n";
     }
 }
 
+void stop_writer_at_exit() {
+    writer->stop();
+}
+
 void hlt::log::open(int bot_id) {
-    if (has_opened) {
+    static int opened_bot_id = -1;
+    std::unique_lock<std::mutex> lock(log_buffer_mutex);
+    if (has_opened.load(std::memory_order_relaxed)) {
+        lock.unlock();
+        if (bot_id == opened_bot_id) {
+            // replaying several games as the same bot in one process
+            return;
+        }
         hlt::log::log("Error: log: tried to open(" + std::to_string(bot_id) + ") but we have already opened before.");
         exit(1);
     }
 
-    has_opened = true;
+    opened_bot_id = bot_id;
     std::string filename = "bot-" + std::to_string(bot_id) + ".log";
-    log_file.open(filename, std::ios::trunc | std::ios::out);
+    writer = new AsyncWriter(filename);
+    atexit(stop_writer_at_exit);
 
-    for (const std::string& message : log_buffer) {
-        log_file << message << std::endl;
+    for (std::string& message : log_buffer) {
+        writer->push(std::move(message));
+    }
+    if (dropped_messages > 0) {
+        writer->push(std::to_string(dropped_messages) + " more messages were dropped before the log was opened");
     }
     log_buffer.clear();
+    log_buffer.shrink_to_fit();
+    has_opened.store(true, std::memory_order_release);
 }
 
 void hlt::log::log(const std::string& message) {
-    if (has_opened) {
-        log_file << message << std::endl;
-    } else {
-        if (!has_atexit) {
-            has_atexit = true;
-            atexit(dump_buffer_at_exit);
-        }
-        log_buffer.push_back(message);
+    log(Level::Info, message);
+}
+
+void hlt::log::log(Level level, std::string message) {
+    if (!enabled(level)) {
+        return;
+    }
+    if (!has_opened.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(log_buffer_mutex);
+        // open may have finished while we waited for the lock
+        if (!has_opened.load(std::memory_order_relaxed)) {
+            if (!has_atexit) {
+                has_atexit = true;
+                atexit(dump_buffer_at_exit);
+            }
+            if (log_buffer.size() < LOG_BUFFER_LIMIT) {
+                log_buffer.push_back(std::move(message));
+            } else {
+                dropped_messages++;
+            }
+            return;
+        }
+    }
+    writer->push(std::move(message));
+}
+
+bool hlt::log::enabled(Level level) {
+    return static_cast<int>(level) >= current_level.load(std::memory_order_relaxed);
+}
+
+void hlt::log::set_level(Level level) {
+    current_level.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+void hlt::log::flush() {
+    if (has_opened.load(std::memory_order_acquire)) {
+        writer->flush();
     }
 }
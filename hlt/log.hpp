@@ -2,9 +2,58 @@
 
 #include <string>
 
+// Messages below this level are compiled out of the LOG_* macros entirely:
+// 0 keeps everything, 1 drops debug, 2 keeps warnings and errors, 3 only errors.
+// It is also the level logged until set_level changes it.
+#ifndef HLT_LOG_MIN_LEVEL
+#define HLT_LOG_MIN_LEVEL 1
+#endif
+
 namespace hlt {
     namespace log {
+        enum class Level {
+            Debug = 0,
+            Info = 1,
+            Warning = 2,
+            Error = 3,
+        };
+
+        /**
+         * Starts writing bot-<bot_id>.log. Messages logged before are kept, up
+         * to a limit, and written first; if the log is never opened, as in
+         * the offline tools, they go to bot-unknown-<time>.log at exit.
+         */
         void open(int bot_id);
+
+        /** Logs at Info level. */
         void log(const std::string& message);
+        void log(Level level, std::string message);
+
+        /** Whether messages of this level are currently written. */
+        bool enabled(Level level);
+        void set_level(Level level);
+
+        /**
+         * Blocks until everything logged so far is in the log file.
+         * Messages are written by a background thread, so call this once per turn
+         * rather than after every message.
+         */
+        void flush();
     }
 }
+
+/**
+ * Logs the message only if its level is enabled. The message expression is not
+ * evaluated at all otherwise, so building the string costs nothing when filtered.
+ */
+#define HLT_LOG(level, message)                                                     \
+    do {                                                                            \
+        if (static_cast<int>(level) >= HLT_LOG_MIN_LEVEL && hlt::log::enabled(level)) { \
+            hlt::log::log(level, (message));                                        \
+        }                                                                           \
+    } while (false)
+
+#define LOG_DEBUG(message) HLT_LOG(hlt::log::Level::Debug, message)
+#define LOG_INFO(message) HLT_LOG(hlt::log::Level::Info, message)
+#define LOG_WARNING(message) HLT_LOG(hlt::log::Level::Warning, message)
+#define LOG_ERROR(message) HLT_LOG(hlt::log::Level::Error, message)
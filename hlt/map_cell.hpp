@@ -6,31 +6,33 @@
 #include "dropoff.hpp"
 
 namespace hlt {
+    struct GameMap;
+
+    /**
+     * A view of a single cell of the GameMap.
+     * The map keeps its cells as flat arrays (see GameMap); a MapCell only
+     * points into them, so it is cheap to create and must not outlive the map.
+     */
     struct MapCell {
+        GameMap* map;
+        int index;
         Position position;
-        Halite halite;
-        std::shared_ptr<Ship> ship;
-        std::shared_ptr<Entity> structure; // only has dropoffs and shipyards; if id is -1, then it's a shipyard, otherwise it's a dropoff
+        Halite& halite;
 
-        MapCell(int x, int y, Halite halite) :
-            position(x, y),
+        MapCell(GameMap* map, int index, const Position& position, Halite& halite) :
+            map(map),
+            index(index),
+            position(position),
             halite(halite)
         {}
 
-        bool is_empty() const {
-            return !ship && !structure;
-        }
-
-        bool is_occupied() const {
-            return static_cast<bool>(ship);
-        }
+        bool is_empty() const;
+        bool is_occupied() const;
+        bool has_structure() const;
 
-        bool has_structure() const {
-            return static_cast<bool>(structure);
-        }
+        Ship* ship() const;
+        PlayerId structure_owner() const;
 
-        void mark_unsafe(std::shared_ptr<Ship>& ship) {
-            this->ship = ship;
-        }
+        void mark_unsafe(Ship* ship);
     };
 }
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+namespace hlt {
+    /**
+     * Memory for node-based containers whose size has a known bound, such as
+     * the maps from entity ids. Nodes given back are reused for new ones, and
+     * reserve sets memory aside up front, so the containers only reach the
+     * heap once they outgrow what was reserved.
+     */
+    class NodePool : public std::pmr::memory_resource {
+    public:
+        /**
+         * Bytes set aside per entry: a map node from an id to a pointer or a
+         * small value, with room for the pool's rounding and for the bucket
+         * arrays the map leaves behind as it grows.
+         */
+        static constexpr std::size_t ENTRY_BYTES = 128;
+
+        NodePool() : pool(std::make_unique<std::pmr::unsynchronized_pool_resource>()) {}
+        explicit NodePool(std::size_t entries) { reserve(entries); }
+
+        /**
+         * Sets memory aside for this many entries, over all the containers
+         * using the pool. Only call it while nothing is allocated from it.
+         */
+        void reserve(std::size_t entries) {
+            const std::size_t bytes = entries * ENTRY_BYTES;
+            pool.reset();
+            upstream.reset();
+            // left uninitialized, so pages no entry reaches are never touched
+            buffer.reset(new std::byte[bytes]);
+            upstream = std::make_unique<std::pmr::monotonic_buffer_resource>(buffer.get(), bytes);
+            pool = std::make_unique<std::pmr::unsynchronized_pool_resource>(upstream.get());
+        }
+
+    private:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+            return pool->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+            pool->deallocate(p, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+        // destroyed bottom up: the pool returns its chunks before the buffer goes
+        std::unique_ptr<std::byte[]> buffer;
+        std::unique_ptr<std::pmr::monotonic_buffer_resource> upstream;
+        std::unique_ptr<std::pmr::unsynchronized_pool_resource> pool;
+    };
+}
@@ -1,27 +1,62 @@
 #include "player.hpp"
-#include "input.hpp"
 
-void hlt::Player::_update(int num_ships, int num_dropoffs, Halite halite) {
-    this->halite = halite;
+void hlt::Player::_reserve(size_t max_entities) {
+    entity_nodes.reserve(2 * max_entities);
+    new_dropoffs.reserve(max_entities);
+    lost_ships.reserve(max_entities);
+}
 
-    ships.clear();
+void hlt::Player::_update(hlt::Input& input, EntityPool<Ship>& ship_pool, EntityPool<Dropoff>& dropoff_pool,
+                          int num_ships, int num_dropoffs, Halite halite) {
+    _begin_update(ship_pool, halite);
     for (int i = 0; i < num_ships; ++i) {
-        std::shared_ptr<hlt::Ship> ship = hlt::Ship::_generate(id);
-        ships[ship->id] = ship;
+        _update_ship(ship_pool, hlt::Ship::_generate(input, id));
     }
-
-    dropoffs.clear();
     for (int i = 0; i < num_dropoffs; ++i) {
-        std::shared_ptr<hlt::Dropoff> dropoff = hlt::Dropoff::_generate(id);
-        dropoffs[dropoff->id] = dropoff;
+        _update_dropoff(dropoff_pool, hlt::Dropoff::_generate(input, id));
+    }
+    _end_update(ship_pool);
+}
+
+void hlt::Player::_begin_update(EntityPool<Ship>& ship_pool, Halite halite) {
+    this->halite = halite;
+    ship_pool.begin_frame();
+    new_dropoffs.clear();
+    lost_ships.clear();
+}
+
+hlt::Ship* hlt::Player::_update_ship(EntityPool<Ship>& ship_pool, const Ship& ship) {
+    hlt::Ship* stored = ship_pool.update(ship);
+    ships[stored->id] = stored;
+    return stored;
+}
+
+void hlt::Player::_update_dropoff(EntityPool<Dropoff>& dropoff_pool, const Dropoff& dropoff) {
+    // dropoffs are never destroyed, so only new ones need to be added;
+    // try_emplace, unlike emplace, allocates no node for the ones we know
+    hlt::Dropoff* stored = dropoff_pool.update(dropoff);
+    if (dropoffs.try_emplace(stored->id, stored).second) {
+        new_dropoffs.push_back(stored);
+    }
+}
+
+void hlt::Player::_end_update(EntityPool<Ship>& ship_pool) {
+    // ships no longer reported have been destroyed
+    for (auto it = ships.begin(); it != ships.end();) {
+        if (ship_pool.seen_this_frame(it->first)) {
+            ++it;
+        } else {
+            ship_pool.release(it->first);
+            lost_ships.push_back(it->first);
+            it = ships.erase(it);
+        }
     }
 }
 
-std::shared_ptr<hlt::Player> hlt::Player::_generate() {
-    PlayerId player_id;
-    int shipyard_x;
-    int shipyard_y;
-    hlt::get_sstream() >> player_id >> shipyard_x >> shipyard_y;
+std::shared_ptr<hlt::Player> hlt::Player::_generate(hlt::Input& input) {
+    PlayerId player_id = input.next_int();
+    int shipyard_x = input.next_int();
+    int shipyard_y = input.next_int();
 
     return std::make_shared<hlt::Player>(player_id, shipyard_x, shipyard_y);
 }
@@ -4,8 +4,12 @@
 #include "shipyard.hpp"
 #include "ship.hpp"
 #include "dropoff.hpp"
+#include "entity_pool.hpp"
+#include "distance_field.hpp"
+#include "node_pool.hpp"
 
 #include <memory>
+#include <memory_resource>
 #include <unordered_map>
 
 namespace hlt {
@@ -13,16 +17,39 @@ namespace hlt {
         PlayerId id;
         std::shared_ptr<Shipyard> shipyard;
         Halite halite;
-        std::unordered_map<EntityId, std::shared_ptr<Ship>> ships;
-        std::unordered_map<EntityId, std::shared_ptr<Dropoff>> dropoffs;
+        NodePool entity_nodes; // the nodes of ships and dropoffs; declared first, so it outlives them
+        // non-owning; the records live in the Game's entity pools
+        std::pmr::unordered_map<EntityId, Ship*> ships;
+        std::pmr::unordered_map<EntityId, Dropoff*> dropoffs;
+        std::vector<Dropoff*> new_dropoffs; // dropoffs first reported in the latest frame
+        std::vector<EntityId> lost_ships;   // ships destroyed in the latest frame
+        DistanceField home_distance; // distance to the closest of shipyard and dropoffs
 
         Player(PlayerId player_id, int shipyard_x, int shipyard_y) :
             id(player_id),
             shipyard(std::make_shared<Shipyard>(player_id, shipyard_x, shipyard_y)),
-            halite(0)
+            halite(0),
+            ships(&entity_nodes),
+            dropoffs(&entity_nodes)
         {}
 
-        void _update(int num_ships, int num_dropoffs, Halite halite);
-        static std::shared_ptr<Player> _generate();
+        /**
+         * Makes room for this many ships and as many dropoffs, so that following
+         * the game allocates nothing. Call before the first frame.
+         */
+        void _reserve(size_t max_entities);
+
+        void _update(Input& input, EntityPool<Ship>& ship_pool, EntityPool<Dropoff>& dropoff_pool,
+                     int num_ships, int num_dropoffs, Halite halite);
+
+        /**
+         * The steps of _update, for callers that already have the frame as values
+         * (such as a simulator): begin, report every ship and dropoff, then end.
+         */
+        void _begin_update(EntityPool<Ship>& ship_pool, Halite halite);
+        Ship* _update_ship(EntityPool<Ship>& ship_pool, const Ship& ship);
+        void _update_dropoff(EntityPool<Dropoff>& dropoff_pool, const Dropoff& dropoff);
+        void _end_update(EntityPool<Ship>& ship_pool);
+        static std::shared_ptr<Player> _generate(Input& input);
     };
 }
@@ -3,6 +3,7 @@
 #include "entity.hpp"
 #include "constants.hpp"
 #include "command.hpp"
+#include "input.hpp"
 
 #include <memory>
 
@@ -15,8 +16,8 @@ namespace hlt {
             halite(halite)
         {}
 
-        bool is_full() const {
-            return halite >= constants::MAX_HALITE;
+        bool is_full(const Constants& constants) const {
+            return halite >= constants.MAX_HALITE;
         }
 
         Command make_dropoff() const {
@@ -31,6 +32,6 @@ namespace hlt {
             return hlt::command::move(id, Direction::STILL);
         }
 
-        static std::shared_ptr<Ship> _generate(PlayerId player_id);
+        static Ship _generate(Input& input, PlayerId player_id);
     };
 }
@@ -0,0 +1,4 @@
+#include "alloc_tracker.hpp"
+
+std::atomic<long long> AllocTracker::allocations_(0);
+bool AllocTracker::enabled_ = false;
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <atomic>
+
+/// Counts the heap allocations of the process, on every thread.
+/// The counting is done by the replacement operator new in alloc_hooks.cpp,
+/// which is only linked into the bot when it is built with
+/// -DMYBOT_ALLOC_TRACKING=ON (bench always has it). Without it every count
+/// stays 0 and enabled() is false, so callers can ask unconditionally.
+/// The planning pool's threads count towards the turn they work for, and so
+/// does the logger's writer thread.
+class AllocTracker {
+public:
+    /// Allocations made so far.
+    static long long allocations() { return allocations_.load(std::memory_order_relaxed); }
+
+    /// Whether operator new is being counted.
+    static bool enabled() { return enabled_; }
+
+    /// Called by the hooks.
+    static void countAllocation() { allocations_.fetch_add(1, std::memory_order_relaxed); }
+    static void enable() { enabled_ = true; }
+
+private:
+    static std::atomic<long long> allocations_;
+    static bool enabled_;
+};
@@ -0,0 +1,245 @@
+#include "assignment.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <queue>
+
+using namespace std;
+
+static const int UNASSIGNED = -1;
+// the agent prefers having no target to every candidate at current prices
+static const int NO_TARGET = -2;
+
+/// Translate candidate targets into dense object indices.
+static pmr::vector<int> collectObjects(const CandidateLists& candidates, pmr::vector<pmr::vector<int>>& objects) {
+    pmr::vector<int> targets(candidates.get_allocator());
+    for (const auto& agentCandidates : candidates) {
+        for (const AssignmentCandidate& candidate : agentCandidates) {
+            targets.push_back(candidate.target);
+        }
+    }
+    sort(targets.begin(), targets.end());
+    targets.erase(unique(targets.begin(), targets.end()), targets.end());
+
+    objects.clear();
+    objects.resize(candidates.size());
+    for (size_t agent = 0; agent < candidates.size(); agent++) {
+        for (const AssignmentCandidate& candidate : candidates[agent]) {
+            auto it = lower_bound(targets.begin(), targets.end(), candidate.target);
+            objects[agent].push_back(int(it - targets.begin()));
+        }
+    }
+    return targets;
+}
+
+static pmr::vector<int> toTargets(const pmr::vector<int>& agentObject, const pmr::vector<int>& targets) {
+    pmr::vector<int> result(agentObject.size(), -1, agentObject.get_allocator());
+    for (size_t agent = 0; agent < agentObject.size(); agent++) {
+        if (agentObject[agent] >= 0) {
+            result[agent] = targets[agentObject[agent]];
+        }
+    }
+    return result;
+}
+
+void TargetAssigner::fillGreedily(const pmr::vector<pmr::vector<int>>& objects, const CandidateLists& candidates,
+                                  pmr::vector<int>& agentObject, pmr::vector<int>& objectOwner) {
+    for (size_t agent = 0; agent < candidates.size(); agent++) {
+        if (agentObject[agent] >= 0) {
+            continue;
+        }
+        int bestObject = UNASSIGNED;
+        double bestScore = 0;
+        for (size_t c = 0; c < candidates[agent].size(); c++) {
+            int object = objects[agent][c];
+            if (objectOwner[object] == UNASSIGNED && candidates[agent][c].score > bestScore) {
+                bestScore = candidates[agent][c].score;
+                bestObject = object;
+            }
+        }
+        if (bestObject != UNASSIGNED) {
+            objectOwner[bestObject] = int(agent);
+            agentObject[agent] = bestObject;
+        }
+    }
+}
+
+pmr::vector<int> TargetAssigner::solveGreedy(const CandidateLists& candidates) {
+    pmr::memory_resource* memory = candidates.get_allocator().resource();
+    pmr::vector<pmr::vector<int>> objects(memory);
+    pmr::vector<int> targets = collectObjects(candidates, objects);
+    pmr::vector<int> agentObject(candidates.size(), UNASSIGNED, memory);
+    pmr::vector<int> objectOwner(targets.size(), UNASSIGNED, memory);
+    fillGreedily(objects, candidates, agentObject, objectOwner);
+    return toTargets(agentObject, targets);
+}
+
+pmr::vector<int> TargetAssigner::solve(const CandidateLists& candidates,
+                                       chrono::microseconds budget, bool* usedFallback) {
+    pmr::memory_resource* memory = candidates.get_allocator().resource();
+    auto deadline = chrono::steady_clock::now() + budget;
+    if (usedFallback) {
+        *usedFallback = false;
+    }
+
+    pmr::vector<pmr::vector<int>> objects(memory);
+    pmr::vector<int> targets = collectObjects(candidates, objects);
+    size_t nAgents = candidates.size();
+
+    double maxScore = 0;
+    for (const auto& agentCandidates : candidates) {
+        for (const AssignmentCandidate& candidate : agentCandidates) {
+            maxScore = max(maxScore, candidate.score);
+        }
+    }
+
+    pmr::vector<int> agentObject(nAgents, UNASSIGNED, memory);
+    pmr::vector<int> objectOwner(targets.size(), UNASSIGNED, memory);
+    if (maxScore <= 0) {
+        return toTargets(agentObject, targets);
+    }
+
+    // The auction ends within nAgents * epsilon of the best total score; scaling
+    // epsilon down keeps the early phases cheap while prices settle.
+    pmr::vector<double> price(targets.size(), 0.0, memory);
+    double epsilon = maxScore / 4;
+    double finalEpsilon = maxScore * 1e-4 / double(nAgents + 1);
+    bool outOfTime = false;
+    int bidCount = 0;
+
+    for (;;) {
+        fill(agentObject.begin(), agentObject.end(), UNASSIGNED);
+        fill(objectOwner.begin(), objectOwner.end(), UNASSIGNED);
+        queue<int, pmr::deque<int>> unassigned{ pmr::deque<int>(memory) };
+        for (size_t agent = 0; agent < nAgents; agent++) {
+            unassigned.push(int(agent));
+        }
+
+        while (!unassigned.empty()) {
+            if ((++bidCount & 63) == 0 && chrono::steady_clock::now() > deadline) {
+                outOfTime = true;
+                break;
+            }
+            int agent = unassigned.front();
+            unassigned.pop();
+
+            // having no target is always worth 0
+            double bestValue = 0;
+            double secondValue = 0;
+            int bestObject = NO_TARGET;
+            for (size_t c = 0; c < candidates[agent].size(); c++) {
+                int object = objects[agent][c];
+                double value = candidates[agent][c].score - price[object];
+                if (value > bestValue) {
+                    secondValue = bestValue;
+                    bestValue = value;
+                    bestObject = object;
+                }
+                else if (value > secondValue) {
+                    secondValue = value;
+                }
+            }
+
+            agentObject[agent] = bestObject;
+            if (bestObject == NO_TARGET) {
+                continue;
+            }
+            price[bestObject] += bestValue - secondValue + epsilon;
+            int previousOwner = objectOwner[bestObject];
+            if (previousOwner != UNASSIGNED) {
+                agentObject[previousOwner] = UNASSIGNED;
+                unassigned.push(previousOwner);
+            }
+            objectOwner[bestObject] = agent;
+        }
+
+        if (outOfTime || epsilon <= finalEpsilon) {
+            break;
+        }
+        epsilon /= 5;
+    }
+
+    if (outOfTime) {
+        if (usedFallback) {
+            *usedFallback = true;
+        }
+        fillGreedily(objects, candidates, agentObject, objectOwner);
+    }
+    return toTargets(agentObject, targets);
+}
+
+void MinCostMatcher::reserve(int cols) {
+    // rows <= cols
+    reserveGrowing(rowPotential_, cols + 1);
+    reserveGrowing(columnPotential_, cols + 1);
+    reserveGrowing(minSlack_, cols + 1);
+    reserveGrowing(columnRow_, cols + 1);
+    reserveGrowing(previousColumn_, cols + 1);
+    reserveGrowing(visited_, cols + 1);
+}
+
+bool MinCostMatcher::solve(int rows, int cols, const vector<double>& cost, vector<int>& rowColumn) {
+    reserve(cols);
+    reserveGrowing(rowColumn, rows);
+    // potentials and matches are 1-based; column 0 is a virtual start column
+    rowPotential_.assign(rows + 1, 0);
+    columnPotential_.assign(cols + 1, 0);
+    columnRow_.assign(cols + 1, 0);
+    previousColumn_.assign(cols + 1, 0);
+    for (int row = 1; row <= rows; row++) {
+        columnRow_[0] = row;
+        int column = 0;
+        minSlack_.assign(cols + 1, numeric_limits<double>::infinity());
+        visited_.assign(cols + 1, 0);
+        // grow a shortest augmenting path from the new row
+        do {
+            visited_[column] = 1;
+            const int pathRow = columnRow_[column];
+            double delta = numeric_limits<double>::infinity();
+            int nextColumn = 0;
+            for (int j = 1; j <= cols; j++) {
+                if (visited_[j]) {
+                    continue;
+                }
+                const double slack = cost[(pathRow - 1) * cols + (j - 1)] - rowPotential_[pathRow] - columnPotential_[j];
+                if (slack < minSlack_[j]) {
+                    minSlack_[j] = slack;
+                    previousColumn_[j] = column;
+                }
+                if (minSlack_[j] < delta) {
+                    delta = minSlack_[j];
+                    nextColumn = j;
+                }
+            }
+            for (int j = 0; j <= cols; j++) {
+                if (visited_[j]) {
+                    rowPotential_[columnRow_[j]] += delta;
+                    columnPotential_[j] -= delta;
+                }
+                else {
+                    minSlack_[j] -= delta;
+                }
+            }
+            column = nextColumn;
+        } while (columnRow_[column] != 0);
+        // flip the path
+        do {
+            const int previous = previousColumn_[column];
+            columnRow_[column] = columnRow_[previous];
+            column = previous;
+        } while (column != 0);
+    }
+
+    rowColumn.assign(rows, -1);
+    bool feasible = true;
+    for (int j = 1; j <= cols; j++) {
+        const int row = columnRow_[j];
+        if (row != 0) {
+            rowColumn[row - 1] = j - 1;
+            feasible = feasible && cost[(row - 1) * cols + (j - 1)] < FORBIDDEN;
+        }
+    }
+    return feasible;
+}
+
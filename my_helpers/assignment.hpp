@@ -0,0 +1,76 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <memory_resource>
+#include <vector>
+
+using namespace std;
+
+/// A target an agent may be assigned to, and how much the agent wants it.
+struct AssignmentCandidate {
+    int target;
+    double score;
+};
+
+/// The candidate list of every agent.
+typedef pmr::vector<pmr::vector<AssignmentCandidate>> CandidateLists;
+
+/// Assigns agents (ships) to distinct targets (cells) so that the total score
+/// is as high as possible. Each agent only considers its own candidate list
+/// and may stay unassigned; each target goes to at most one agent.
+/// The solvers allocate their scratch space and result from the memory
+/// resource the candidates live in, such as the bot's TurnArena.
+class TargetAssigner {
+public:
+    /// Solve with an epsilon-scaling auction. If the time budget runs out, the
+    /// assignments made so far are kept and the remaining agents are filled in
+    /// greedily, in agent order.
+    /// Returns the target of every agent, or -1 for unassigned agents.
+    static pmr::vector<int> solve(const CandidateLists& candidates,
+                                  chrono::microseconds budget, bool* usedFallback = nullptr);
+
+    /// Give each agent, in order, its best candidate nobody has taken yet.
+    static pmr::vector<int> solveGreedy(const CandidateLists& candidates);
+
+private:
+    /// Greedily assign the agents that have no object yet.
+    static void fillGreedily(const pmr::vector<pmr::vector<int>>& objects, const CandidateLists& candidates,
+                             pmr::vector<int>& agentObject, pmr::vector<int>& objectOwner);
+};
+
+/// Make room for at least n elements, at least doubling the capacity, so that a
+/// buffer reused for problems of growing size only reallocates a few times.
+template <typename T>
+void reserveGrowing(vector<T>& buffer, size_t n) {
+    if (buffer.capacity() < n) {
+        buffer.reserve(max(n, 2 * buffer.capacity()));
+    }
+}
+
+/// Exact minimum cost assignment of every row (a ship) to a distinct column
+/// (a cell), with the Hungarian algorithm in O(rows^2 * cols). The buffers are
+/// kept between calls and grow by doubling, so solving many small problems
+/// allocates nothing once the largest one has been seen.
+class MinCostMatcher {
+public:
+    /// Marks a row and column that must not be matched.
+    static constexpr double FORBIDDEN = 1e12;
+
+    /// cost holds rows x cols entries, row after row, with rows <= cols.
+    /// Fills rowColumn with the column of every row. Returns false if every
+    /// complete assignment uses a FORBIDDEN entry.
+    bool solve(int rows, int cols, const vector<double>& cost, vector<int>& rowColumn);
+
+    /// Size the buffers for problems up to cols columns up front.
+    void reserve(int cols);
+
+private:
+    vector<double> rowPotential_;
+    vector<double> columnPotential_;
+    vector<double> minSlack_;
+    vector<int> columnRow_; // 1-based row matched to each column, 0 for none
+    vector<int> previousColumn_;
+    vector<char> visited_;
+};
+
@@ -0,0 +1,321 @@
+#include "bot.hpp"
+#include "movement_map.hpp"
+#include "navigator.hpp"
+#include "tunables.hpp"
+#include "miscs.hpp"
+#include "turn_budget.hpp"
+#include "profiler.hpp"
+#include "alloc_tracker.hpp"
+#include "hlt/constants.hpp"
+#include "hlt/log.hpp"
+
+#include <algorithm>
+#include <string>
+#include <thread>
+
+using namespace std;
+using namespace hlt;
+
+static int calculateCurrentShipCapacity(Game& game, const GameTunables& tunables) {
+    double turnRatio = (double)game.turn_number / game.constants.MAX_TURNS;
+    int start = tunables.lookUpTunable(Tunable::shipCapStart);
+    int end = tunables.lookUpTunable(Tunable::shipCapEnd);
+    int diff = start - end;
+    int shipCapacity = start - int(turnRatio * diff);
+    return shipCapacity;
+}
+
+static void logShipStatus(Ship* ship, ShipStatus status) {
+    if (status == ShipStatus::NEW) {
+        LOG_DEBUG("Ship " + ship->position.toString() + " NEW");
+    }
+    else if (status == ShipStatus::EXPLORE) {
+        LOG_DEBUG("Ship " + ship->position.toString() + " EXPLORE");
+    }
+    else if (status == ShipStatus::RETURN) {
+        LOG_DEBUG("Ship " + ship->position.toString() + " RETURN");
+    }
+    else {
+        LOG_DEBUG("Ship " + ship->position.toString() + " COLLECT");
+    }
+}
+
+static void adjustState(Ship* ship, shared_ptr<Player> me, Game &game, shared_ptr<GameMap>& game_map,
+                 pmr::unordered_map<EntityId, ShipStatus>& shipStatus, Navigator &navigator,
+                 const GameTunables& tunables, bool allShipsShouldReturn) {
+    PROFILE_SCOPE(adjustState);
+    // newly created ship
+    LOG_DEBUG(std::to_string(navigator.getPickUpThreshold()));
+
+    if (allShipsShouldReturn) {
+        shipStatus[ship->id] = ShipStatus::RETURN;
+    }
+
+    if (shipStatus[ship->id] == ShipStatus::NEW) {
+        shipStatus[ship->id] = ShipStatus::EXPLORE;
+    }
+
+    if (!shipStatus.count(ship->id)) {
+        shipStatus[ship->id] = ShipStatus::NEW;
+    }
+
+    if (ship->position == me->shipyard->position) {
+        shipStatus[ship->id] = ShipStatus::NEW;
+    }
+
+    for (auto dropoffPair : me->dropoffs) {
+        Position dropoffPos = dropoffPair.second->position;
+        if (ship->position == dropoffPos) {
+            shipStatus[ship->id] = ShipStatus::NEW;
+        }
+    }
+
+    if (shipStatus[ship->id] == ShipStatus::EXPLORE) {
+        if (game_map->at(ship->position).halite >= navigator.getPickUpThreshold() and
+             not ship->is_full(game.constants)) {
+            shipStatus[ship->id] = ShipStatus::COLLECT;
+        }
+        else if (ship->halite >= calculateCurrentShipCapacity(game, tunables)) {
+            shipStatus[ship->id] = ShipStatus::RETURN;
+        }
+    }
+    if (shipStatus[ship->id] == ShipStatus::COLLECT) {
+        if (game_map->at(ship->position).halite >= navigator.getPickUpThreshold() * 2 and
+             not (ship->halite >= calculateCurrentShipCapacity(game, tunables) + 20)) {
+            shipStatus[ship->id] = ShipStatus::COLLECT;
+        }
+        else if (ship->halite >= calculateCurrentShipCapacity(game, tunables)) {
+            shipStatus[ship->id] = ShipStatus::RETURN;
+        }
+        else {
+            shipStatus[ship->id] = ShipStatus::EXPLORE;
+        }
+    }
+    if (shipStatus[ship->id] == ShipStatus::RETURN) {
+        // if ((game_map->at(ship->position).halite >= 2 * navigator.getPickUpThreshold()) and
+        //      not (ship->halite > 900)) {
+        //     shipStatus[ship->id] = ShipStatus::COLLECT;
+        // }
+    }
+
+    logShipStatus(ship, shipStatus[ship->id]);
+}
+
+static bool hasHighSurroundingHalite(Game &game,Ship* ship) {
+    shared_ptr<GameMap>& game_map = game.game_map;
+    // nine blocks has an average halite of 200
+    long long totalHalite = game_map->rectangle_halite(ship->position, 2, 2);
+    LOG_DEBUG("High surrounding halite " + ship->position.toString());
+    return totalHalite >= 200 * 25;
+}
+
+static bool hasSurroundingDropOffs(Game &game,Ship* ship) {
+    int noDropoffRadius = 13;
+    return game.me->home_distance.at(*game.game_map, ship->position) < noDropoffRadius;
+}
+
+int Bot::findHaliteAbundanceKey(Game& game) {
+    int averageHalite = findAverageHalite(game.game_map);
+    if (averageHalite < 116) {
+        return 0;
+    }
+    else if (averageHalite < 194) {
+        return 1;
+    }
+    else {
+        return 2;
+    }
+}
+
+static bool allShipsReturn(Game& game) {
+    int turn = game.turn_number;
+    int maxturn = game.constants.MAX_TURNS;
+    int mapsize = game.game_map->height;
+
+    int turnsleft = maxturn - turn;
+    if (turnsleft <= mapsize / 2.5) {
+        return true;
+    }
+    else return false;
+}
+
+Bot::Bot(Game& game, unsigned int rngSeed, shared_ptr<const Tunables> tunables) :
+    rng_(rngSeed), tunables_(tunables),
+    nPlayers_(game.players.size()), mapSize_(game.game_map->width), haliteAbundance_(findHaliteAbundanceKey(game)),
+    shipNodes_(2 * size_t(game.game_map->width) * game.game_map->height),
+    shipStatus_(&shipNodes_), exploreTargets_(&shipNodes_),
+    movementMap_(game.game_map, game.me, nPlayers_, game.constants.MAX_HALITE),
+    timeLimited_(true), numDropOffCreated_(0), dropOffCreatedThisTurn_(false), turnsPlayed_(0),
+    arena_(ARENA_BYTES_PER_CELL * game.game_map->width * game.game_map->height) {
+    // exits now rather than on the first turn if no csv file fits this game
+    tunables_->lookUpValues(nPlayers_, mapSize_, haliteAbundance_);
+    Navigator::reserveThreadScratch(mapSize_);
+}
+
+Bot::Bot(Game& game, unsigned int rngSeed, const string& pathToFolder) :
+    Bot(game, rngSeed, Tunables::load(pathToFolder)) {}
+
+void Bot::setTunables(shared_ptr<const Tunables> tunables) {
+    atomic_store(&tunables_, tunables);
+}
+
+shared_ptr<const Tunables> Bot::tunables() const {
+    return atomic_load(&tunables_);
+}
+
+void Bot::setPlanningThreads(unsigned int threads) {
+    if (threads == 0) {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    // the bot's own thread plans too, so the pool gets one thread fewer
+    planningPool_ = threads > 1 ? make_unique<WorkStealingPool>(threads - 1) : nullptr;
+    if (planningPool_) {
+        const int mapWidth = mapSize_;
+        planningPool_->runOnEveryThread([mapWidth] { Navigator::reserveThreadScratch(mapWidth); });
+    }
+}
+
+void Bot::setTimeLimited(bool timeLimited) {
+    timeLimited_ = timeLimited;
+}
+
+bool Bot::openTrace(const string& path, Game& game) {
+    return trace_.open(path, game.my_id, *game.game_map);
+}
+
+void Bot::writeTrace(Game& game, const vector<Command>& commands) {
+    traceTurn_.clear();
+    traceTurn_.turn = game.turn_number;
+    GameMap& gameMap = *game.game_map;
+    for (int cell : gameMap.changed_cells) {
+        traceTurn_.haliteChanges.push_back({ cell, gameMap.halite[cell] });
+    }
+    for (const auto& ship_iterator : game.me->ships) {
+        Ship* ship = ship_iterator.second;
+        auto statusIt = shipStatus_.find(ship->id);
+        const ShipStatus status = statusIt != shipStatus_.end() ? statusIt->second : ShipStatus::NEW;
+        traceTurn_.ships.push_back({ ship->id, gameMap.index(ship->position), ship->halite, uint8_t(status) });
+        auto target = exploreTargets_.find(ship->id);
+        if ((status == ShipStatus::NEW or status == ShipStatus::EXPLORE) and target != exploreTargets_.end()) {
+            traceTurn_.targets.push_back({ ship->id, target->second });
+        }
+    }
+    movementMap_.traceIntents(traceTurn_);
+    for (const Command& command : commands) {
+        traceTurn_.addCommand(command);
+    }
+    trace_.write(traceTurn_);
+    // the engine kills the bot after the last turn, so the file is trimmed here
+    if (game.turn_number >= game.constants.MAX_TURNS) {
+        trace_.close();
+    }
+}
+
+const vector<Command>& Bot::playTurn(Game& game) {
+    const long long allocationsAtStart = AllocTracker::allocations();
+    arena_.reset();
+    pmr::memory_resource* memory = arena_.resource();
+    TurnBudget budget = timeLimited_ ? TurnBudget() : TurnBudget::unlimited();
+    // one set of values for the whole turn, even if setTunables swaps them meanwhile
+    const GameTunables tunables(*this->tunables(), nPlayers_, mapSize_, haliteAbundance_);
+    shared_ptr<Player> me = game.me;
+    shared_ptr<GameMap>& game_map = game.game_map;
+
+    // the per-ship state only has to follow the ships that changed
+    for (EntityId lostShip : me->lost_ships) {
+        shipStatus_.erase(lostShip);
+        exploreTargets_.erase(lostShip);
+    }
+
+    bool allShipsShouldReturn = allShipsReturn(game);
+    bool collisionCenterOkay = allShipsShouldReturn;
+
+    MovementMap& movementMap = movementMap_;
+    movementMap.startTurn(collisionCenterOkay, game.boards, budget);
+    Navigator navigator = Navigator(game_map, me, game.boards, shipStatus_, rng_, exploreTargets_, potentialField_, budget, tunables,
+                                    planningPool_.get(), memory);
+
+    for (const auto& ship_iterator : me->ships) {
+        Ship* ship = ship_iterator.second;
+        adjustState(ship, me, game, game_map, shipStatus_, navigator, tunables, allShipsShouldReturn);
+    }
+    pmr::vector<Ship*> exploringShips(memory);
+    for (const auto& ship_iterator : me->ships) {
+        Ship* ship = ship_iterator.second;
+        if (shipStatus_[ship->id] == ShipStatus::NEW or shipStatus_[ship->id] == ShipStatus::EXPLORE) {
+            exploringShips.push_back(ship);
+        }
+    }
+    navigator.planExploreTargets(exploringShips);
+    dropOffCreatedThisTurn_ = false;
+    for (const auto& ship_iterator : me->ships) {
+        Ship* ship = ship_iterator.second;
+        pmr::vector<Direction> nextDirs(memory);
+
+        // just a quick add-in:
+        // if I just happen to have 20+ ships before turn 200,
+        // and I haven't got any drop-offs before
+        // and there exist a ship such that their avarage surrounding
+        // halite is greater than 300, that ship then becomes a dropoff.
+        // I also need to have enough money.
+        if ( budget.checkpoint("dropoff") != TurnBudget::Level::MINIMAL and
+             numDropOffCreated_ < int(me->ships.size() / 13) and
+             game.turn_number <= game.constants.MAX_TURNS - tunables.lookUpTunable(Tunable::noProdTurn) + 50 and
+             me->halite >= 5000 and
+             !dropOffCreatedThisTurn_ and
+             hasHighSurroundingHalite(game, ship) and
+             !hasSurroundingDropOffs(game, ship)
+        )
+        {
+            movementMap.makeDropoff(ship);
+            dropOffCreatedThisTurn_ = true;
+            numDropOffCreated_ += 1;
+            continue;
+        }
+
+        else if (shipStatus_[ship->id] == ShipStatus::NEW) {
+            nextDirs = navigator.newShip(ship);
+        }
+        else if (shipStatus_[ship->id] == ShipStatus::EXPLORE) {
+            nextDirs = navigator.explore(ship);
+        }
+        else if (shipStatus_[ship->id] == ShipStatus::COLLECT) {
+            nextDirs = navigator.collect(ship);
+        }
+        else if (shipStatus_[ship->id] == ShipStatus::RETURN) {
+            nextDirs = navigator.dropoffHalite(ship);
+        }
+
+        movementMap.addIntent(ship, nextDirs);
+    }
+    if (game.turn_number <= game.constants.MAX_TURNS - tunables.lookUpTunable(Tunable::noProdTurn) and 
+        me->halite >= game.constants.SHIP_COST) {
+        
+        if (me->ships.size() >= 16 and 
+            numDropOffCreated_ < int(me->ships.size() / 13) and
+             game.turn_number > 110 and
+             numDropOffCreated_ < 4 and
+             me->halite < 5000) {
+            // here, we reserve the halite just to be able to create a dropoff
+            // do nothing
+        }
+        else {
+            movementMap.makeShip();
+        }
+    }
+
+    movementMap.logTurn(me);
+    const vector<Command>& commands = movementMap.processOutputs(me);
+    movementMap.logTurn(me);
+    budget.logTurn(game.turn_number);
+    if (trace_.isOpen()) {
+        writeTrace(game, commands);
+    }
+    const long long allocations = AllocTracker::allocations() - allocationsAtStart;
+    // the first turn sets up the buffers the others reuse
+    if (AllocTracker::enabled() && allocations > TURN_ALLOCATION_BUDGET && turnsPlayed_ > 0) {
+        LOG_WARNING("Turn " + to_string(game.turn_number) + " made " + to_string(allocations) + " heap allocations");
+    }
+    turnsPlayed_++;
+    return commands;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "hlt/game.hpp"
+#include "hlt/command.hpp"
+#include "hlt/node_pool.hpp"
+#include "shipStatus.hpp"
+#include "tunables.hpp"
+#include "potential_field.hpp"
+#include "movement_map.hpp"
+#include "trace.hpp"
+#include "turn_arena.hpp"
+#include "work_stealing_pool.hpp"
+
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+using namespace hlt;
+
+/// The bot's decision making, apart from talking to the engine.
+/// It is given a Game whose frame is up to date and answers with the
+/// commands for the turn, so it can play against the real engine
+/// (MyBot.cpp) as well as inside a simulator.
+class Bot {
+public:
+    /// Plays with the tunables for this game's player count, map size and halite.
+    Bot(Game& game, unsigned int rngSeed, shared_ptr<const Tunables> tunables);
+    /// pathToFolder is the folder holding the csv folder.
+    Bot(Game& game, unsigned int rngSeed, const string& pathToFolder);
+
+    /// Play with other tunables from the next turn on. May be called from
+    /// another thread while the bot is playing.
+    void setTunables(shared_ptr<const Tunables> tunables);
+    shared_ptr<const Tunables> tunables() const;
+
+    /// Plan on this many threads, the calling one included; 0 means one per
+    /// hardware thread. The default of 1 suits bots that share the host with
+    /// other games, as in the simulator. The commands do not depend on it.
+    void setPlanningThreads(unsigned int threads);
+
+    /// Whether turns degrade as they run out of the engine's time (the
+    /// default). Without the limit, every turn plans fully and its commands
+    /// only depend on the game and the rng seed, as simulated games need.
+    void setTimeLimited(bool timeLimited);
+
+    /// Process one turn
+    /// You can take at most 2 seconds per turn.
+    /// The commands stay valid until the next call.
+    const vector<Command>& playTurn(Game& game);
+
+    /// 0, 1 or 2 for maps with little, average or much halite.
+    static int findHaliteAbundanceKey(Game& game);
+
+    /// Record every turn from now on in a binary trace file (see TraceWriter).
+    /// Call before the first turn.
+    bool openTrace(const string& path, Game& game);
+
+    /// Heap allocations a turn may make once the game is under way: none.
+    /// The bot logs a warning for turns over it when counting
+    /// (MYBOT_ALLOC_TRACKING), and replay and bench fail on them.
+    static const long long TURN_ALLOCATION_BUDGET = 0;
+
+private:
+    void writeTrace(Game& game, const vector<Command>& commands);
+
+    mt19937 rng_;
+    shared_ptr<const Tunables> tunables_; // only touched through atomic_load and atomic_store
+    int nPlayers_;
+    int mapSize_;
+    int haliteAbundance_;
+    // the nodes of the two maps below, set aside for as many ships as the map has cells
+    NodePool shipNodes_;
+    pmr::unordered_map<EntityId, ShipStatus> shipStatus_;
+    // the explore target of each ship, kept for turns that run out of time
+    pmr::unordered_map<EntityId, int> exploreTargets_;
+    // planning state that follows the game turn over turn instead of being rebuilt
+    PotentialField potentialField_;
+    MovementMap movementMap_;
+    bool timeLimited_;
+    int numDropOffCreated_;
+    bool dropOffCreatedThisTurn_;
+    int turnsPlayed_;
+    TraceWriter trace_;
+    TraceTurn traceTurn_;
+    // the navigator's scratch space; everything in it is dropped at the start of a turn
+    TurnArena arena_;
+    // about twice the most any recorded or benchmarked turn has used, so the
+    // arena does not have to grow during the game
+    static const size_t ARENA_BYTES_PER_CELL = 1024;
+    // the threads helping the bot's own with planning, none by default
+    unique_ptr<WorkStealingPool> planningPool_;
+};
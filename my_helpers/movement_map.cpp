@@ -1,303 +1,324 @@
 #include "movement_map.hpp"
+#include "profiler.hpp"
 
-#include <queue>
-#include <stack>
 #include <algorithm>
-#include <random>
 
 using namespace std;
 using namespace hlt;
 
 /// *************** Public section ****************
 
-MovementMap::MovementMap(shared_ptr<GameMap>& gameMap, shared_ptr<Player>& me, int nPlayers, mt19937& rng,
-    bool collisionCenterOkay) :
-rng_(rng) {
+MovementMap::MovementMap(shared_ptr<GameMap>& gameMap, shared_ptr<Player>& me, int nPlayers, int maxHalite) {
     me_ = me;
     nPlayers_ = nPlayers;
+    maxHalite_ = maxHalite;
     gameMap_ = gameMap;
-    shipsComingtoPos_ = {};
-    shipDirectionQueue_ = {};
-    allConflicts_ = {};
+    shouldMakeShip_ = false;
+    collisionCenterOkay_ = false;
+    budget_ = nullptr;
+    holdAllShips_ = false;
+
+    const size_t cells = size_t(gameMap_->width) * gameMap_->height;
+    intentAt_.assign(cells, NONE);
+    isHome_.assign(cells, 0);
+    endsHere_.assign(cells, 0);
+    cellIntent_.assign(cells, NONE);
+    column_.assign(cells, NONE);
+    // a cell holds at most one of our ships, and each ship has at most five
+    // distinct cells to end on, so the per-ship buffers never outgrow these
+    intents_.reserve(cells);
+    candidates_.reserve(cells * 5);
+    firstCandidate_.reserve(cells + 1);
+    parent_.reserve(cells);
+    componentOrder_.reserve(cells);
+    componentStart_.reserve(cells + 1);
+    homeCells_.reserve(cells);
+    command_queue_.reserve(cells + 1);
+    // the matching buffers grow with the largest component; most stay far below this
+    const int COMPONENT_SHIPS = 32;
+    reserveGrowing(columnCell_, COMPONENT_SHIPS * 5);
+    reserveGrowing(cost_, COMPONENT_SHIPS * COMPONENT_SHIPS * 5);
+    reserveGrowing(rowColumn_, COMPONENT_SHIPS);
+    matcher_.reserve(COMPONENT_SHIPS * 5);
+}
+
+void MovementMap::startTurn(bool collisionCenterOkay, const OccupancyBoards& boards, TurnBudget& budget) {
+    // every cell last turn wrote to is a ship's or one of its candidates
+    for (const Intent& intent : intents_) {
+        intentAt_[intent.cell] = NONE;
+    }
+    for (const Candidate& candidate : candidates_) {
+        endsHere_[candidate.cell] = 0;
+        cellIntent_[candidate.cell] = NONE;
+    }
+    for (int cell : homeCells_) {
+        isHome_[cell] = 0;
+    }
+    intents_.clear();
+    candidates_.clear();
+    homeCells_.clear();
+    command_queue_.clear();
     shouldMakeShip_ = false;
     collisionCenterOkay_ = collisionCenterOkay;
-    vector<Command> command_queue_ = {};
+    budget_ = &budget;
+    holdAllShips_ = false;
+
+    homeCells_.push_back(gameMap_->index(me_->shipyard->position));
+    for (auto dropoffPair : me_->dropoffs) {
+        homeCells_.push_back(gameMap_->index(dropoffPair.second->position));
+    }
+    for (int cell : homeCells_) {
+        isHome_[cell] = 1;
+    }
+
+    if (nPlayers_ == 4) {
+        // a crash on our own structures leaves the halite to us, so ships
+        // may run into enemies there; anywhere else they never do
+        enemyShips_ = boards.enemy_ships;
+        enemyShips_.remove(boards.own_structures);
+        // our shipyard, and the cells we may share, are never worth avoiding
+        Bitboard safe(gameMap_->width, gameMap_->height);
+        safe.set(me_->shipyard->position);
+        if (collisionCenterOkay_) {
+            safe |= boards.own_structures;
+        }
+        enemyNearby_ = boards.enemy_reach;
+        enemyNearby_.remove(boards.own_ships | boards.enemy_ships);
+        enemyNearby_.remove(safe);
+    }
 }
 
-void MovementMap::addIntent(shared_ptr<Ship> ship, vector<Direction> preferredDirs, bool ignoreOpponentFlag) {
+void MovementMap::addIntent(Ship* ship, const pmr::vector<Direction>& preferredDirs, bool ignoreOpponentFlag) {
     //log::log("Add intent: ship " + to_string(ship->id));
-    shipIgnoresOpponent_[ship->position] = ignoreOpponentFlag;
+    const int shipCell = gameMap_->index(ship->position);
+    int intent = intentAt_[shipCell];
+    if (intent == NONE) {
+        intent = int(intents_.size());
+        intents_.push_back(Intent());
+        intents_[intent].ship = ship;
+        intents_[intent].cell = shipCell;
+        intents_[intent].chosen = Direction::STILL;
+        intentAt_[shipCell] = intent;
+    }
+    Intent& shipIntent = intents_[intent];
+    shipIntent.ignoresOpponent = ignoreOpponentFlag;
     if (!gameMap_->can_move(ship)) {
-        shipDirectionQueue_[ship->position].push(Direction::STILL);
-        shipsComingtoPos_[ship->position].push_back(ship);
+        shipIntent.count = 0;
+        shipIntent.directions[shipIntent.count++] = Direction::STILL;
         return;
     }
-    Position currentPos = ship->position;
     for (Direction dir : preferredDirs) {
-        shipDirectionQueue_[ship->position].push(dir);
-    }
-    if (preferredDirs.empty()) {
-        //log::log("Preferred direction should not be empty!");
-        preferredDirs.push_back(Direction::STILL);
+        if (shipIntent.count < MAX_DIRECTIONS) {
+            shipIntent.directions[shipIntent.count++] = dir;
+        }
     }
-    Direction mostPreferredDir = preferredDirs[0];
-    Position newPos = gameMap_->destination_position(currentPos, mostPreferredDir);
-    shipsComingtoPos_[newPos].push_back(ship);
 }
 
 bool MovementMap::isFreeSpace(Position pos) {
-    return shipsComingtoPos_[pos].size() == 0;
+    return endsHere_[gameMap_->index(pos)] == 0;
 }
 
-void MovementMap::makeDropoff(shared_ptr<Ship> ship) {
+void MovementMap::makeDropoff(Ship* ship) {
     command_queue_.push_back(ship->make_dropoff());
-    log::log("Make Dropoff");
+    LOG_INFO("Make Dropoff");
 }
 
 void MovementMap::makeShip() {
     shouldMakeShip_ = true;
 }
 
-/// Flush the outputs to Halite game engine
-bool MovementMap::processOutputsAndEndTurn(Game& game, shared_ptr<Player> me) {
+/// Resolve all conflicts and return the commands for this turn
+const vector<Command>& MovementMap::processOutputs(shared_ptr<Player> me) {
     // Resolve all conflicts
     resolveAllConflicts();
 
     // Get all the directions
     //log::log("Real OUT");
-    for (auto kv : shipDirectionQueue_) {
-        Position shipPos = kv.first;
-        shared_ptr<Ship> ship = gameMap_->at(shipPos)->ship;
-        Direction dir = currentDirection(ship);
-        command_queue_.push_back(ship->move(dir));
-        //Position nextPos = destinationPos(ship);
-        //log::log("ship " + to_string(ship->id) + " position " + ship->position.toString() +
-        //         " -> " + nextPos.toString());
+    for (const Intent& intent : intents_) {
+        Direction dir = holdAllShips_ ? Direction::STILL : intent.chosen;
+        command_queue_.push_back(intent.ship->move(dir));
     }
 
     // Spawn a ship
-    if (shouldMakeShip_ && isFreeSpace(me->shipyard->position)) {
+    if (shouldMakeShip_ && !holdAllShips_ && isFreeSpace(me->shipyard->position)) {
         command_queue_.push_back(me->shipyard->spawn());
     }
-    return game.end_turn(command_queue_);
+    return command_queue_;
 }
 
 void MovementMap::logTurn(shared_ptr<Player> me) {
     //log::log("log turn");
     for (auto ship_iterator : me->ships) {
-        shared_ptr<Ship> ship = ship_iterator.second;
+        [[maybe_unused]] Ship* ship = ship_iterator.second;
         //Position nextPos = destinationPos(ship);
         //log::log("ship " + to_string(ship->id) + " position " + ship->position.toString() +
         //        " -> " + nextPos.toString());
     }
 }
 
-/// *************** Private section ****************
-
-Direction MovementMap::currentDirection(shared_ptr<Ship> ship) {
-    Position shipPos = ship->position;
-    if (shipDirectionQueue_[shipPos].empty()) {
-        return Direction::STILL;
+void MovementMap::traceIntents(TraceTurn& turn) const {
+    for (const Intent& intent : intents_) {
+        turn.intents.push_back({ intent.ship->id, intent.count });
+        turn.intentDirections.insert(turn.intentDirections.end(), intent.directions, intent.directions + intent.count);
     }
-    return shipDirectionQueue_[shipPos].front();
 }
 
-Position MovementMap::destinationPos(shared_ptr<Ship> ship) {
-    Direction currentDir = currentDirection(ship);
-    Position targetDir = gameMap_->destination_position(ship->position, currentDir);
-    return targetDir;
-}
+/// *************** Private section ****************
 
-bool MovementMap::shipHasLessHalite(const shared_ptr<Ship>& ship1, const shared_ptr<Ship>& ship2) {
-    return ship1->halite < ship2->halite;
+bool MovementMap::isShared(int cell) const {
+    // at the end of the game ships may crash into each other on our dropoffs
+    return collisionCenterOkay_ && isHome_[cell];
 }
 
-/// Change the direction of ship to be the next direction in queue
-void MovementMap::changeToNextDirection(shared_ptr<Ship> ship) {
-    Position currentPos = ship->position;
-    Position nextPos = destinationPos(ship);
-
-    // remove
-    auto eraseIndex = find(shipsComingtoPos_[nextPos].begin(), shipsComingtoPos_[nextPos].end(), ship);
-    shipsComingtoPos_[nextPos].erase(eraseIndex);
-
-    shipDirectionQueue_[currentPos].pop();
-
-    // add : we have to get the destination again because
-    // the current destination of the ship has changed by popping
-    nextPos = destinationPos(ship);
-    shipsComingtoPos_[nextPos].push_back(ship);
+bool MovementMap::hasEnemyShip(int cell) const {
+    return enemyShips_.test(gameMap_->position(cell));
 }
 
-void MovementMap::redirectShip(shared_ptr<Ship> ship) {
-    //log::log("ship " + to_string(ship->id) + " redirection:" + ship->position.toString());
-    while(hasConflict(ship) && currentDirection(ship) != Direction::STILL) {
-        changeToNextDirection(ship);
-        //log::log("new direction: " + to_string(currentDirection(ship)));
-    }
-    if(hasConflict(ship)) {
-        allConflicts_.push(ship->position);
-    }
+double MovementMap::enemyRisk(int cell) const {
+    return enemyNearby_.test(gameMap_->position(cell)) ? ENEMY_NEARBY_STEPS : 0;
 }
 
-void MovementMap::redirectShips(vector<shared_ptr<Ship>> ships) {
-    for (shared_ptr<Ship> ship : ships) {
-        redirectShip(ship);
-    }
-}
-
-bool MovementMap::hasEnemyPresence(Position& centerPos) {
-    for (Position surroundingPos : centerPos.get_surrounding_cardinals()) {
-        surroundingPos = gameMap_->normalize(surroundingPos);
-        MapCell* surroundingCell = gameMap_->at(surroundingPos);
-        if (surroundingCell->is_occupied() and surroundingCell->ship->owner != me_->id) {
-            log::log("enemy presence at " + centerPos.toString());
-            return true;
+void MovementMap::collectCandidates() {
+    candidates_.clear();
+    firstCandidate_.clear();
+    for (const Intent& intent : intents_) {
+        const size_t first = candidates_.size();
+        firstCandidate_.push_back(int(first));
+        const int ownCell = gameMap_->index(intent.ship->position);
+        // every step down the list costs more for a ship carrying more halite
+        const double stepCost = 1.0 + double(intent.ship->halite) / maxHalite_;
+        bool hasOwnCell = false;
+        for (int rank = 0; rank < intent.count; rank++) {
+            const Direction dir = intent.directions[rank];
+            const int cell = gameMap_->index(gameMap_->destination_position(intent.ship->position, dir));
+            bool listed = false;
+            for (size_t i = first; i < candidates_.size(); i++) {
+                listed = listed || candidates_[i].cell == cell;
+            }
+            // moving onto an enemy is never an option, however far down the list staying is
+            if (listed || (cell != ownCell && hasEnemyShip(cell))) {
+                continue;
+            }
+            hasOwnCell = hasOwnCell || cell == ownCell;
+            const double risk = cell == ownCell ? 0 : enemyRisk(cell);
+            candidates_.push_back({ cell, dir, (rank + risk) * stepCost });
+        }
+        if (!hasOwnCell) {
+            // staying still is always possible: no other ship of ours is on this cell
+            candidates_.push_back({ ownCell, Direction::STILL, intent.count * stepCost });
         }
     }
-    return false;
+    firstCandidate_.push_back(int(candidates_.size()));
 }
 
-bool MovementMap::hasEnemyShip(Position& pos) {
-    MapCell* cell = gameMap_->at(pos);
-    if (cell->is_occupied() && cell->ship->owner != me_->id) {
-        log::log("occupied " + pos.toString());
-        return true;
+int MovementMap::findRoot(int intent) {
+    while (parent_[intent] != intent) {
+        parent_[intent] = parent_[parent_[intent]];
+        intent = parent_[intent];
     }
-    return false;
+    return intent;
 }
 
-/// Does this block has conflict
-bool MovementMap::hasConflict(Position& pos) {
-    if (collisionCenterOkay_) {
-        // allow collision on dropoffs and shipyard
-        vector<Position> homePositions;
-        homePositions.push_back(me_->shipyard->position);
-        for (auto dropoffPair : me_->dropoffs) {
-            homePositions.push_back(dropoffPair.second->position);
-        }
-
-        for (Position homePos : homePositions) {
-            if (homePos == pos) {
-                return false;
-            }
-        }
+void MovementMap::findComponents() {
+    const int n = int(intents_.size());
+    parent_.resize(n);
+    for (int i = 0; i < n; i++) {
+        parent_[i] = i;
     }
-    if (shipsComingtoPos_[pos].size() >= 2) {
-        return true;
-    }
-    // check for enemy conflict
-    if (nPlayers_ == 4) {
-        if (pos != me_->shipyard->position) {
-            if (shipsComingtoPos_[pos].size() >= 1) {
-                if (hasEnemyShip(pos)) {
-                    if (rng_() % 100 > 2) {
-                        return true;
-                    }
-                }
-                // if we already has a ship there, then
-                // it is not a conflict!
-                if (!gameMap_->at(pos)->is_occupied() and hasEnemyPresence(pos)) {
-                    // in this case, we might hit an enemy. To be safe, we will say
-                    // that we will have a 8% chance of not seeing the conflict.
-                    if (rng_() % 100 > 8) {
-                        return true;
-                    }
-                }
+    for (int i = 0; i < n; i++) {
+        for (int c = firstCandidate_[i]; c < firstCandidate_[i + 1]; c++) {
+            if (isShared(candidates_[c].cell)) {
+                // ships never compete for a shared cell
+                continue;
+            }
+            int& other = cellIntent_[candidates_[c].cell];
+            if (other == NONE) {
+                other = i;
+            }
+            else {
+                parent_[findRoot(i)] = findRoot(other);
             }
         }
     }
-    return false;
-}
-
-bool MovementMap::hasConflict(shared_ptr<Ship> ship) {
-    Position targetDir = destinationPos(ship);
-    return hasConflict(targetDir);
-}
-
-void MovementMap::iterateAndResolveConflicts() {
-    while(!allConflicts_.empty()) {
-        Position conflictMiddlePos = allConflicts_.front();
-        allConflicts_.pop();
-        log::log("conflict: " + conflictMiddlePos.toString());
-        resolveConflict(conflictMiddlePos);
+    for (int i = 0; i < n; i++) {
+        parent_[i] = findRoot(i);
     }
-}
 
-void MovementMap::resolveConflict(Position middlePos) {
-    log::log("resolve: " + middlePos.toString());
-    MapCell* middleCell = gameMap_->at(middlePos);
-    // running into an enemy
-    if (middleCell->is_occupied() && middleCell->ship->owner != me_->id) {
-        log::log("detected");
-        vector<shared_ptr<Ship>> shipsToRedirect = shipsComingtoPos_[middlePos];
-        redirectShips(shipsToRedirect);
+    componentOrder_.resize(n);
+    for (int i = 0; i < n; i++) {
+        componentOrder_[i] = i;
     }
-    
-    // If the middle position is empty, we allow the
-    // ship with the greatest halite to go to the destination,
-    // but don't allow other ships.
-    else if(!middleCell->is_occupied()) {
-        if (hasEnemyPresence(middlePos)) {
-            // avoid enemies case
-            vector<shared_ptr<Ship>> shipsToRedirect = shipsComingtoPos_[middlePos];
-            redirectShips(shipsToRedirect);
-        }
-        else {
-            // in this case it is O -> X <- O
-            // get all the ships pointing here
-            vector<shared_ptr<Ship>> shipsToRedirect = shipsComingtoPos_[middlePos];
-            auto maxShipIndex = max_element(shipsToRedirect.begin(), shipsToRedirect.end(),
-                                            shipHasLessHalite);
-            shared_ptr<Ship> maxShip = *maxShipIndex;
-            shipsToRedirect.erase(maxShipIndex);
-            
-            redirectShips(shipsToRedirect);
+    sort(componentOrder_.begin(), componentOrder_.end(), [this](int a, int b) {
+        return parent_[a] != parent_[b] ? parent_[a] < parent_[b] : a < b;
+    });
+    componentStart_.clear();
+    for (int i = 0; i < n; i++) {
+        if (i == 0 || parent_[componentOrder_[i]] != parent_[componentOrder_[i - 1]]) {
+            componentStart_.push_back(i);
         }
     }
-    // O -> O <- O
-    // If the middle position is not empty we allow the middle ship
-    // to choose what to do, that is, we direct all other ships that the middle
-    // ship is not pointing to.
-    // If the middle ship chooses to stay still, then all other ships will have to
-    // redirect.
-    else {
-        // if it is occupied, then it has a ship.
-        // Case : it is not out ship
-        shared_ptr<Ship> middleShip = gameMap_->at(middlePos)->ship;
-        vector<shared_ptr<Ship>> shipsToRedirect = shipsComingtoPos_[middlePos];
-        if (middleShip->owner != me_->id) {
-            redirectShips(shipsToRedirect);
+    componentStart_.push_back(n);
+}
+
+void MovementMap::solveComponent(int begin, int end) {
+    const int rows = end - begin;
+    // one column per cell, or one per ship for cells they may share
+    columnCell_.clear();
+    for (int r = begin; r < end; r++) {
+        const int intent = componentOrder_[r];
+        for (int c = firstCandidate_[intent]; c < firstCandidate_[intent + 1]; c++) {
+            const int cell = candidates_[c].cell;
+            if (column_[cell] == NONE) {
+                column_[cell] = int(columnCell_.size());
+                reserveGrowing(columnCell_, columnCell_.size() + (isShared(cell) ? rows : 1));
+                columnCell_.insert(columnCell_.end(), isShared(cell) ? rows : 1, cell);
+            }
         }
-        if(currentDirection(middleShip) == Direction::STILL) {
-            redirectShips(shipsToRedirect);
+    }
+    const int cols = int(columnCell_.size());
+    reserveGrowing(cost_, size_t(rows) * cols);
+    cost_.assign(size_t(rows) * cols, MinCostMatcher::FORBIDDEN);
+    for (int r = begin; r < end; r++) {
+        const int intent = componentOrder_[r];
+        for (int c = firstCandidate_[intent]; c < firstCandidate_[intent + 1]; c++) {
+            const Candidate& candidate = candidates_[c];
+            const int copies = isShared(candidate.cell) ? rows : 1;
+            for (int k = 0; k < copies; k++) {
+                cost_[size_t(r - begin) * cols + column_[candidate.cell] + k] = candidate.cost;
+            }
         }
-        else {
-            // looking at where the current ship is pointing to
-            Direction middleDir = currentDirection(middleShip);
-            // the ship at the position can move to the middle, if it wants.
-            // that is, it does not have to redirect if it is in the list.
-            Position safeShipPos = gameMap_->destination_position(middlePos, middleDir);
-            for (shared_ptr<Ship> shipToRedirect : shipsToRedirect) {
-                if (shipToRedirect->position != safeShipPos) {
-                    redirectShip(shipToRedirect);
-                }
+    }
+
+    // always feasible: every ship can stay on its own cell
+    matcher_.solve(rows, cols, cost_, rowColumn_);
+    for (int r = begin; r < end; r++) {
+        Intent& intent = intents_[componentOrder_[r]];
+        const int cell = columnCell_[rowColumn_[r - begin]];
+        for (int c = firstCandidate_[componentOrder_[r]]; c < firstCandidate_[componentOrder_[r] + 1]; c++) {
+            if (candidates_[c].cell == cell) {
+                intent.chosen = candidates_[c].direction;
+                break;
             }
         }
+        endsHere_[cell]++;
+    }
+    for (int cell : columnCell_) {
+        column_[cell] = NONE;
     }
-    
 }
 
-/// Initialize allConflicts_ and call resolve all
+/// Match every component of ships to cells
 void MovementMap::resolveAllConflicts() {
-    // Loop through the shipsComingtoPos_, obtain all conflicts
-    // and keep it in a stack.
-    for (auto kv : shipsComingtoPos_) {
-        Position pos = kv.first;
-        //log::log("conflict check at " + pos.toString());
-        if (hasConflict(pos)) {
-            allConflicts_.push(pos);
+    PROFILE_SCOPE(resolveAllConflicts);
+    budget_->checkpoint("resolve conflicts");
+    collectCandidates();
+    findComponents();
+    for (size_t i = 0; i + 1 < componentStart_.size(); i++) {
+        if (budget_->expired()) {
+            LOG_WARNING("Out of time resolving conflicts, holding all ships");
+            holdAllShips_ = true;
+            return;
         }
+        solveComponent(componentStart_[i], componentStart_[i + 1]);
     }
-    iterateAndResolveConflicts();
-}
\ No newline at end of file
+}
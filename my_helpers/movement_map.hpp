@@ -6,11 +6,14 @@
 #include "hlt/dropoff.hpp"
 #include "hlt/game.hpp"
 #include "hlt/constants.hpp"
+#include "hlt/bitboard.hpp"
+#include "turn_budget.hpp"
+#include "assignment.hpp"
+#include "trace.hpp"
 
-#include <queue>
-#include <stack>
 #include <algorithm>
-#include <random>
+#include <cstdint>
+#include <memory_resource>
 
 using namespace std;
 using namespace hlt;
@@ -18,81 +21,136 @@ using namespace hlt;
 /// Class movement map keeps track of each bot's immediate movement intent
 /// It contains the logic of safety navigation and flushing the (safe) movements
 /// to the output.
+/// All our ships are moved at once: ships that could end up on the same cell
+/// form a component, and each component is solved as a minimum cost matching
+/// of ships to cells, where a ship pays for every step down its list of
+/// preferred directions, more so the more halite it carries. Swaps and cycles
+/// of ships are fine, and no two of our ships ever end on the same cell
+/// (except on our own dropoffs once collisionCenterOkay).
 class MovementMap {
 public:
     /// Create a movement map that keeps track of immediate movement and safety.
-    /// 
-    MovementMap(shared_ptr<GameMap>& gameMap, shared_ptr<Player>& me, int nPlayers_, mt19937& rng, bool collisionCenterOkay);
+    /// It lives for the whole game; call startTurn before every turn.
+    /// maxHalite is the game's Constants::MAX_HALITE.
+    MovementMap(shared_ptr<GameMap>& gameMap, shared_ptr<Player>& me, int nPlayers_, int maxHalite);
+
+    /// Forget last turn's intents. Only the cells last turn touched are
+    /// cleared, so this costs as much as our fleet, not the map.
+    void startTurn(bool collisionCenterOkay, const OccupancyBoards& boards, TurnBudget& budget);
 
     /// Tell the map that the ship is intending to move in the following direction(s)
     /// Adding a direction here implies that the second direction is 
     /// almost as good as the first one.
-    void addIntent(shared_ptr<Ship> ship, vector<Direction> preferredDirs, bool ignoreOpponentFlag = false);
+    void addIntent(Ship* ship, const pmr::vector<Direction>& preferredDirs, bool ignoreOpponentFlag = false);
 
     /// Only call after resolve all conflicts()
     bool isFreeSpace(Position pos);
 
-    void makeDropoff(shared_ptr<Ship> ship);
+    void makeDropoff(Ship* ship);
 
     /// Create an intention to make ship
     void makeShip();
 
-    /// Flush the outputs to Halite game engine
-    bool processOutputsAndEndTurn(Game& game, shared_ptr<Player> me);
+    /// Resolve all conflicts and return the commands for this turn.
+    /// They stay valid until the next startTurn.
+    const vector<Command>& processOutputs(shared_ptr<Player> me);
 
     void logTurn(shared_ptr<Player> me);
 
-private:
-    /// The direction a ship is intending to go
-    Direction currentDirection(shared_ptr<Ship> ship);
-
-    /// The immediate destination (next block) the ship is intending to
-    /// go.
-    Position destinationPos(shared_ptr<Ship> ship);
-
-    /// Does ship1 has less halite than ship2?
-    static bool shipHasLessHalite(const shared_ptr<Ship>& ship1, const shared_ptr<Ship>& ship2);
-
-    /// Change the direction of the ship to the next possible move.
-    void changeToNextDirection(shared_ptr<Ship> ship);
-
-    /// Redirect a ship until it has no conflict or has stopped.
-    void redirectShip(shared_ptr<Ship> ship);
-
-    void redirectShips(vector<shared_ptr<Ship>> ships);
+    /// Add this turn's intents, in the order they were made, to a trace record.
+    void traceIntents(TraceTurn& turn) const;
 
-    /// Does this block has conflict?
-    bool hasConflict(Position& pos);
-
-    /// Does this ship has conflict?
-    bool hasConflict(shared_ptr<Ship> ship);
-
-    /// resolve all conflicts
-    void iterateAndResolveConflicts();
-
-    /// resolve a conflict at the position middlePos
-    void resolveConflict(Position middlePos);
+private:
+    // at most this many directions are kept per ship; newShip asks for seven
+    static const int MAX_DIRECTIONS = 8;
+    static constexpr int NONE = -1;
+
+    /// The moves one of our ships would like to make, best first.
+    struct Intent {
+        Ship* ship;
+        int cell; // where the ship is
+        Direction directions[MAX_DIRECTIONS];
+        uint8_t count;
+        bool ignoresOpponent;
+        Direction chosen; // set by resolveAllConflicts
+    };
+
+    /// A cell a ship may end the turn on, and what it costs the ship.
+    struct Candidate {
+        int cell;
+        Direction direction;
+        double cost;
+    };
+
+    // extra cost, in steps down a ship's list, of ending next to an enemy
+    static constexpr double ENEMY_NEARBY_STEPS = 1.5;
+
+    /// Is there an enemy ship to stay clear of on this cell? Ships never move
+    /// onto one, except on our own structures. Only 4 player games, where
+    /// crashing helps the other two, care.
+    bool hasEnemyShip(int cell) const;
+
+    /// How risky it is to move onto this cell in steps down a ship's list:
+    /// an enemy next to it may crash into us there. 4 player games only too.
+    double enemyRisk(int cell) const;
+
+    /// May several of our ships end the turn on this cell?
+    bool isShared(int cell) const;
+
+    /// Fill candidates_ with the cells each ship may go to.
+    void collectCandidates();
+
+    /// Group the ships that share a candidate cell; fills componentOrder_ and componentStart_.
+    void findComponents();
+    int findRoot(int intent);
+
+    /// Match the ships of componentOrder_[begin, end) to cells.
+    void solveComponent(int begin, int end);
 
     /// Resolve the conflicts at all positions
     /// by changing the intent of ships surrounding those positions.
     void resolveAllConflicts();
 
-    /// Is there an ememy ship at position
-    bool hasEnemyShip(Position& pos);
-
-    /// Is there an enemy ship in the surrounding positions
-    bool hasEnemyPresence(Position& pos);
-    
     shared_ptr<GameMap> gameMap_;
     shared_ptr<Player> me_;
     int nPlayers_;
-    unordered_map<Position, vector<shared_ptr<Ship>>> shipsComingtoPos_;
-    unordered_map<Position, queue<Direction>> shipDirectionQueue_;
-    queue<Position> allConflicts_;
+    int maxHalite_;
+
+    // cells holding an enemy ship (see hasEnemyShip), and empty cells next to
+    // one (see enemyRisk); both are left empty outside 4 player games
+    Bitboard enemyShips_;
+    Bitboard enemyNearby_;
+
+    // Everything below is flat and sized for the map up front, so it never
+    // grows during a turn. The exception is the matching buffers (columnCell_
+    // through matcher_): their worst case is quadratic in the number of ships,
+    // so they are reserved for a 32 ship component and grow by doubling past
+    // that. A turn only allocates when it has a larger component than any
+    // turn before it.
+    vector<Intent> intents_;        // in the order addIntent was called
+    vector<int> intentAt_;          // cell -> index into intents_ of the ship on it, or NONE
+    vector<uint8_t> isHome_;        // per cell: our shipyard or one of our dropoffs
+    vector<int> homeCells_;         // the cells set in isHome_
+    vector<uint8_t> endsHere_;      // per cell: how many of our ships end the turn there
+    vector<Candidate> candidates_;  // the candidates of intent i are [firstCandidate_[i], firstCandidate_[i + 1])
+    vector<int> firstCandidate_;
+    vector<int> parent_;            // union-find over intents
+    vector<int> cellIntent_;        // cell -> some intent with it as a candidate, or NONE
+    vector<int> componentOrder_;    // intents grouped by component
+    vector<int> componentStart_;
+    vector<int> column_;            // cell -> first matching column in the current component, or NONE
+    vector<int> columnCell_;
+    vector<double> cost_;
+    vector<int> rowColumn_;
+    MinCostMatcher matcher_;
+
     vector<Command> command_queue_;
-    mt19937& rng_;
 
-    unordered_map<Position, bool> shipIgnoresOpponent_;
     bool shouldMakeShip_;
     bool collisionCenterOkay_;
+
+    TurnBudget* budget_;
+    // the turn ran out of time while resolving conflicts: every ship stays
+    // still, which can never make two of our ships collide
+    bool holdAllShips_;
 };
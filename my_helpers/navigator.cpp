@@ -1,37 +1,41 @@
 #include "navigator.hpp"
 #include "tunables.hpp"
 #include "shipStatus.hpp"
+#include "assignment.hpp"
+#include "profiler.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 
 using namespace std;
 using namespace hlt;
 
 Navigator::LessFavorablePositionCmp::LessFavorablePositionCmp(
-    shared_ptr<GameMap> gameMap, vector<Position> centerPositions, Position shipPos, double halitePotentialNavigateThreshold) :
-    gameMap_(gameMap), centerPositions_(centerPositions), shipPos_(shipPos),
-    halitePotentialNavigateThreshold_(halitePotentialNavigateThreshold) {}
+    GameMap& gameMap, const DistanceField& homeDistance, const PotentialField& potentialField, Position shipPos,
+    double halitePotentialNavigateThreshold, const GameTunables& tunables) :
+    gameMap_(gameMap), homeDistance_(homeDistance), potentialField_(potentialField), shipPos_(shipPos),
+    halitePotentialNavigateThreshold_(halitePotentialNavigateThreshold) {
+        hltCorr0_ = tunables.lookUpTunable(Tunable::hltCorr0);
+        hltCorr1_ = tunables.lookUpTunable(Tunable::hltCorr1);
+    }
 
 double Navigator::LessFavorablePositionCmp::evaluatePosition(Position pos) const {
-    Tunables tunables;
-    int minDist = 1 << 20;
-    for (Position centerPos : centerPositions_) {
-        int dist = gameMap_->calculate_distance(centerPos, pos);
-        if (dist < minDist) {
-            minDist = dist;
-        }
+    int cellIndex = gameMap_.index(pos);
+    // most cells fall short of the threshold even right next to the ship
+    if (potentialField_.exploreBound(cellIndex) <= halitePotentialNavigateThreshold_) {
+        return 0;
     }
-    int distHome = minDist;
-    int distCollect = gameMap_->calculate_distance(shipPos_, pos);
+    int distHome = homeDistance_.distance[cellIndex];
+    int distCollect = gameMap_.calculate_distance(shipPos_, pos);
     int dist = distHome + distCollect;
-    int halite = std::min(gameMap_->at(pos)->halite, 800);
-    double potential = halite / (dist * tunables.lookUpTunable("hltCorr0") + tunables.lookUpTunable("hltCorr1"));
+    int halite = std::min(gameMap_.halite[cellIndex], PotentialField::EXPLORE_HALITE_CAP);
+    double potential = halite / (dist * hltCorr0_ + hltCorr1_);
     //log::log(pos.toString() + "      " + std::to_string(potential));
     return max(0.0, potential - halitePotentialNavigateThreshold_);
 }
 
-bool Navigator::LessFavorablePositionCmp::noValidPosition(vector<Position> posList) const {
+bool Navigator::LessFavorablePositionCmp::noValidPosition(const pmr::vector<Position>& posList) const {
     for (Position pos : posList) {
         if (evaluatePosition(pos) > 0.1)
             return false;
@@ -39,164 +43,330 @@ bool Navigator::LessFavorablePositionCmp::noValidPosition(vector<Position> posLi
     return true;
 }
 
-vector<Position> Navigator::getSurroundingPositions(Position middlePos, int lookAhead) {
-    vector<Position> posList;
+void Navigator::getSurroundingPositions(Position middlePos, int lookAhead, pmr::vector<Position>& posList) {
+    posList.clear();
     for(int xDiff = -lookAhead; xDiff <= lookAhead; xDiff++) {
         for(int yDiff = -lookAhead; yDiff <= lookAhead; yDiff++) {
-            Position newPos = middlePos + Position(xDiff, yDiff);
-            gameMap_->normalize(newPos);
+            Position newPos = gameMap_->normalize(middlePos + Position(xDiff, yDiff));
             posList.push_back(newPos);
         }
     }
-    return posList;
 }
 
-Navigator::Navigator(shared_ptr<GameMap>& gameMap, shared_ptr<Player>& me, 
-                     unordered_map<EntityId, ShipStatus>& shipStatus, mt19937& rng) :
-    gameMap_(gameMap), me_(me), shipStatus_(shipStatus), usedPosiitons_(), rng_(rng) {
-        maxHalitePotential_ = calculateMaxHalitePotential();
-        log::log("Max Halite Potential " + std::to_string(maxHalitePotential_));
+Navigator::Navigator(shared_ptr<GameMap>& gameMap, shared_ptr<Player>& me, const OccupancyBoards& boards,
+                     pmr::unordered_map<EntityId, ShipStatus>& shipStatus, mt19937& rng,
+                     pmr::unordered_map<EntityId, int>& exploreTargets, PotentialField& potentialField,
+                     TurnBudget& budget, const GameTunables& tunables, WorkStealingPool* pool,
+                     pmr::memory_resource* memory) :
+    gameMap_(gameMap), me_(me), boards_(boards), shipStatus_(shipStatus), usedPosiitons_(memory),
+    assignedTargets_(memory), exploreTargets_(exploreTargets), potentialField_(potentialField), budget_(budget),
+    tunables_(tunables), rng_(rng), pool_(pool), memory_(memory) {
+        PROFILE_SCOPE(navigatorInit);
+        potentialField_.update(*gameMap_, me_->shipyard->position, me_->home_distance,
+                               tunables_.lookUpTunable(Tunable::hltCorr0), tunables_.lookUpTunable(Tunable::hltCorr1));
+        maxHalitePotential_ = potentialField_.maxPotential();
+        LOG_DEBUG("Max Halite Potential " + std::to_string(maxHalitePotential_));
         halitePotentialNavigateThreshold_ = calculateHalitePotentialNavigateThreshold(maxHalitePotential_);
-        Tunables tunables;
-        lowestHaliteToCollect_ = maxHalitePotential_ * tunables.lookUpTunable("colPrecent");
-        log::log("Low Halite Collection " + std::to_string(lowestHaliteToCollect_));  
-    }
-
-double Navigator::calculateMaxHalitePotential() {
-    Tunables tunables;
-    Position shipyard = me_->shipyard->position;
-    int size = gameMap_->width;
-    double maxPotential = 1;
-    for(int x = 0; x < size; x++) {
-        for(int y = 0; y < size; y++) {
-            Position pos = Position(x, y);
-            int dist = gameMap_->calculate_distance(shipyard, pos);
-            int halite = gameMap_->at(pos)->halite;
-            // look at the surrounding position, if the halite at this point is absurdly high,
-            // don't account it for navigation.
-            array<Position, 4> surroundingPositions = pos.get_surrounding_cardinals();
-            int surroundingHalite = 0;
-            for (Position surroundingPos : surroundingPositions) {
-                surroundingHalite += gameMap_->at(surroundingPos)->halite;
-            }
-            surroundingHalite /= 4;
-            if (halite > surroundingHalite * 3) {
-                // this is absurd, probably caused by collision
-                halite = surroundingHalite;
-            }
-            double potential = (halite / (2 * dist * tunables.lookUpTunable("hltCorr0") + tunables.lookUpTunable("hltCorr1")));
-            if (potential > maxPotential) {
-                //log::log(std::to_string(potential));
-                //log::log("halite " + std::to_string(halite));
-                //log::log("dist " + std::to_string(dist));
-                maxPotential = potential;
+        lowestHaliteToCollect_ = maxHalitePotential_ * tunables_.lookUpTunable(Tunable::colPrecent);
+        LOG_DEBUG("Low Halite Collection " + std::to_string(lowestHaliteToCollect_));
+    }
+
+double Navigator::calculateHalitePotentialNavigateThreshold(double maxHalitePotential) {
+    return maxHalitePotential * tunables_.lookUpTunable(Tunable::navPercent);
+}
+
+/// A position only counts as valid if its potential beats the navigation threshold
+/// by 0.1, and no potential exceeds halite / hltCorr1. So a window whose total
+/// halite is below (threshold + 0.1) * hltCorr1 cannot hold a valid position,
+/// which the summed-area table tells us without scoring any cell.
+bool Navigator::windowMayHaveValidPosition(Position middlePos, int lookAhead) {
+    double hltCorr1 = tunables_.lookUpTunable(Tunable::hltCorr1);
+    if (hltCorr1 <= 0) {
+        return true;
+    }
+    double minHalite = (halitePotentialNavigateThreshold_ + 0.1) * hltCorr1;
+    // keep a small margin so rounding never prunes a window noValidPosition would accept
+    return gameMap_->rectangle_halite(middlePos, lookAhead, lookAhead) >= minHalite * 0.999;
+}
+
+/// Grow the window around the ship until it holds a position worth going to.
+/// Returns false if even a window as wide as the map has none, or if the turn
+/// is running late and a window of REDUCED_LOOK_AHEAD has none.
+bool Navigator::findExploreWindow(Position shipPos, const LessFavorablePositionCmp& posFavCmp,
+                                  pmr::vector<Position>& posList) {
+    int maxLookAhead = gameMap_->width;
+    if (budget_.level() >= TurnBudget::Level::REDUCED_LOOKAHEAD) {
+        maxLookAhead = min(maxLookAhead, REDUCED_LOOK_AHEAD + 1);
+    }
+    int shipLookAhead = Tunables::SHIP_LOOKS_AHEAD;
+    for (;;) {
+        if (windowMayHaveValidPosition(shipPos, shipLookAhead)) {
+            getSurroundingPositions(shipPos, shipLookAhead, posList);
+            if (!posFavCmp.noValidPosition(posList)) {
+                return true;
             }
         }
+        shipLookAhead *= 2;
+        //log::log("Ship " + ship->position.toString() + std::to_string(shipLookAhead));
+        if (shipLookAhead >= maxLookAhead) {
+            return false;
+        }
     }
-    return maxPotential;
 }
 
-double Navigator::calculateHalitePotentialNavigateThreshold(double maxHalitePotential) {
-    Tunables tunables;
-    return maxHalitePotential * tunables.lookUpTunable("navPercent");
+/// The target the ship was following last turn, unless it has got there.
+bool Navigator::cachedExploreTarget(Ship* ship, int& target) {
+    auto cached = exploreTargets_.find(ship->id);
+    if (cached == exploreTargets_.end() || cached->second == gameMap_->index(ship->position)) {
+        return false;
+    }
+    target = cached->second;
+    return true;
 }
 
-vector<Direction> Navigator::explore(shared_ptr<Ship> ship) {
-    vector<Position> homePositions;
-    // get all the home positions :
-    homePositions.push_back(me_->shipyard->position);
-    for (auto dropoffPair : me_->dropoffs) {
-        homePositions.push_back(dropoffPair.second->position);
+/// Last turn's target, unless it has been reached, mined below what is worth
+/// going to, claimed by another ship this turn, or an enemy moved next to it.
+bool Navigator::keepsExploreTarget(Ship* ship, const LessFavorablePositionCmp& posFavCmp, int& target) {
+    if (!cachedExploreTarget(ship, target)) {
+        return false;
     }
+    const Position pos = gameMap_->position(target);
+    // the same bar as noValidPosition
+    return posFavCmp.evaluatePosition(pos) > 0.1 &&
+           !usedPosiitons_.count(pos) &&
+           !boards_.enemy_reach.test(pos);
+}
 
-    Position shipPos = ship->position;
-    
+// findExploreCandidates' scratch space, per thread, so the pool's threads
+// can share the work without sharing it; see reserveThreadScratch
+static thread_local pmr::vector<Position> windowScratch;
+static thread_local pmr::vector<AssignmentCandidate> scoredScratch;
 
-    LessFavorablePositionCmp posFavCmp = LessFavorablePositionCmp(gameMap_, homePositions, shipPos, halitePotentialNavigateThreshold_);
-    DirectionHasGreaterHaliteCmp directionHasGreaterHaliteCmp = DirectionHasGreaterHaliteCmp(gameMap_, ship);
+void Navigator::reserveThreadScratch(int mapWidth) {
+    // findExploreWindow doubles the look ahead while it stays below the map width
+    int lookAhead = Tunables::SHIP_LOOKS_AHEAD;
+    while (lookAhead * 2 < mapWidth) {
+        lookAhead *= 2;
+    }
+    const size_t windowCells = size_t(2 * lookAhead + 1) * (2 * lookAhead + 1);
+    windowScratch.reserve(windowCells);
+    scoredScratch.reserve(windowCells);
+}
 
-    int shipLookAhead = Tunables::SHIP_LOOKS_AHEAD;
-    vector<Position> posList = getSurroundingPositions(shipPos, shipLookAhead);
-    while (posFavCmp.noValidPosition(posList)) {
-        shipLookAhead *= 2;
-        //log::log("Ship " + ship->position.toString() + std::to_string(shipLookAhead));
-        posList = getSurroundingPositions(shipPos, shipLookAhead);
+Navigator::CandidateSearch Navigator::findExploreCandidates(Ship* ship, pmr::vector<AssignmentCandidate>& candidates) {
+    pmr::vector<Position>& posList = windowScratch;
+    pmr::vector<AssignmentCandidate>& scored = scoredScratch;
 
-        if (shipLookAhead >= gameMap_->width) {
-            return vector<Direction>();
+    if (budget_.level() == TurnBudget::Level::MINIMAL) {
+        return CandidateSearch::OUT_OF_TIME;
+    }
+    LessFavorablePositionCmp posFavCmp = LessFavorablePositionCmp(*gameMap_, me_->home_distance, potentialField_, ship->position, halitePotentialNavigateThreshold_, tunables_);
+    if (!findExploreWindow(ship->position, posFavCmp, posList)) {
+        return CandidateSearch::NO_WINDOW;
+    }
+    scored.clear();
+    for (Position pos : posList) {
+        double score = posFavCmp.evaluatePosition(pos);
+        // cells kept by other ships are taken
+        if (score > 0 && !usedPosiitons_.count(pos)) {
+            scored.push_back({ gameMap_->index(pos), score });
         }
     }
+    // only the best few cells of a ship can realistically end up as its target
+    if (scored.size() > EXPLORE_CANDIDATES) {
+        nth_element(scored.begin(), scored.begin() + EXPLORE_CANDIDATES, scored.end(),
+                    [](const AssignmentCandidate& a, const AssignmentCandidate& b) { return a.score > b.score; });
+        scored.resize(EXPLORE_CANDIDATES);
+    }
+    candidates.assign(scored.begin(), scored.end());
+    return CandidateSearch::FOUND;
+}
 
-    //TODO: remove the weird ones from the list :
-    vector<Position> filteredPosList;
-    for (Position pos : posList) {
-        if (!usedPosiitons_.count(pos)) {
-            filteredPosList.push_back(pos);
+bool Navigator::shouldWiggle() {
+    return budget_.level() < TurnBudget::Level::NO_WIGGLE;
+}
+
+/// Score the best candidate cells of every exploring ship and hand out the
+/// targets in one go, so that the ships processed first no longer grab the
+/// cells other ships are better placed to reach.
+void Navigator::planExploreTargets(const pmr::vector<Ship*>& ships) {
+    PROFILE_SCOPE(planExploreTargets);
+    CandidateLists candidates(ships.size(), memory_);
+    pmr::vector<size_t> replanned(memory_);
+    for (size_t i = 0; i < ships.size(); i++) {
+        Ship* ship = ships[i];
+        LessFavorablePositionCmp posFavCmp = LessFavorablePositionCmp(*gameMap_, me_->home_distance, potentialField_, ship->position, halitePotentialNavigateThreshold_, tunables_);
+        int target;
+        if (keepsExploreTarget(ship, posFavCmp, target)) {
+            assignedTargets_[ship->id] = target;
+            usedPosiitons_.insert(gameMap_->position(target));
+        }
+        else {
+            replanned.push_back(i);
         }
     }
-    posList = filteredPosList;
 
-    Position maxPos = *max_element(posList.begin(), posList.end(), posFavCmp);
-    usedPosiitons_.insert(maxPos);
+    // The searches only read shared state and each writes its own slots, which
+    // are sized here since the arena is not safe to allocate from on other threads.
+    pmr::vector<CandidateSearch> searches(ships.size(), CandidateSearch::FOUND, memory_);
+    for (size_t i : replanned) {
+        candidates[i].reserve(EXPLORE_CANDIDATES);
+    }
+    budget_.checkpoint("explore candidates");
+    atomic<size_t> nextShip(0);
+    auto searchShips = [&] {
+        // the ships are taken one at a time, so a thread stuck on a wide window holds up nobody
+        for (size_t k = nextShip++; k < replanned.size(); k = nextShip++) {
+            size_t i = replanned[k];
+            searches[i] = findExploreCandidates(ships[i], candidates[i]);
+        }
+    };
+    if (pool_ != nullptr && replanned.size() > 1) {
+        for (unsigned int t = 0; t < pool_->size(); t++) {
+            // a single reference fits in std::function without allocating
+            pool_->submit([&searchShips] { searchShips(); });
+        }
+        searchShips();
+        pool_->wait();
+    }
+    else {
+        searchShips();
+    }
+    budget_.checkpoint("explore candidates");
+    for (size_t i : replanned) {
+        Ship* ship = ships[i];
+        if (searches[i] == CandidateSearch::OUT_OF_TIME) {
+            // the remaining ships keep last turn's target, if any
+            int target;
+            assignedTargets_[ship->id] = cachedExploreTarget(ship, target) ? target : NO_EXPLORE_TARGET;
+        }
+        else if (searches[i] == CandidateSearch::NO_WINDOW) {
+            assignedTargets_[ship->id] = NO_EXPLORE_TARGET;
+        }
+    }
+
+    // an unlimited turn always finishes the auction, so its targets do not depend on timing
+    chrono::microseconds assignmentBudget = budget_.isUnlimited() ? budget_.remaining() :
+        min<chrono::microseconds>(chrono::milliseconds(ASSIGNMENT_BUDGET_MS), budget_.remaining() / 4);
+    bool usedFallback = false;
+    pmr::vector<int> targets = TargetAssigner::solve(candidates, assignmentBudget, &usedFallback);
+    if (usedFallback) {
+        LOG_WARNING("Target assignment ran out of time, finished greedily");
+    }
+    for (size_t i = 0; i < ships.size(); i++) {
+        // ships left without a target pick one themselves in explore()
+        if (targets[i] < 0) {
+            continue;
+        }
+        Position target(targets[i] % gameMap_->width, targets[i] / gameMap_->width);
+        assignedTargets_[ships[i]->id] = targets[i];
+        exploreTargets_[ships[i]->id] = targets[i];
+        usedPosiitons_.insert(target);
+    }
+}
+
+pmr::vector<Direction> Navigator::explore(Ship* ship) {
+    PROFILE_SCOPE(explore);
+    Position shipPos = ship->position;
+
+    LessFavorablePositionCmp posFavCmp = LessFavorablePositionCmp(*gameMap_, me_->home_distance, potentialField_, shipPos, halitePotentialNavigateThreshold_, tunables_);
+    DirectionHasGreaterHaliteCmp directionHasGreaterHaliteCmp = DirectionHasGreaterHaliteCmp(*gameMap_, ship);
+    pmr::vector<Direction> targetDirs(memory_);
+
+    Position maxPos = shipPos;
+    auto assigned = assignedTargets_.find(ship->id);
+    if (assigned != assignedTargets_.end()) {
+        if (assigned->second == NO_EXPLORE_TARGET) {
+            return targetDirs;
+        }
+        maxPos = Position(assigned->second % gameMap_->width, assigned->second / gameMap_->width);
+    }
+    else {
+        int cachedTarget;
+        if (budget_.checkpoint("explore") == TurnBudget::Level::MINIMAL) {
+            if (!cachedExploreTarget(ship, cachedTarget)) {
+                return targetDirs;
+            }
+            Position target(cachedTarget % gameMap_->width, cachedTarget / gameMap_->width);
+            gameMap_->add_unsafe_moves(shipPos, target, targetDirs);
+            return targetDirs;
+        }
+        pmr::vector<Position> posList(memory_);
+        if (!findExploreWindow(shipPos, posFavCmp, posList)) {
+            return targetDirs;
+        }
+
+        // cells other ships are going to are taken
+        posList.erase(remove_if(posList.begin(), posList.end(),
+                                [this](const Position& pos) { return usedPosiitons_.count(pos) > 0; }),
+                      posList.end());
+        if (posList.empty()) {
+            return targetDirs;
+        }
+
+        maxPos = *max_element(posList.begin(), posList.end(), posFavCmp);
+        usedPosiitons_.insert(maxPos);
+        exploreTargets_[ship->id] = gameMap_->index(maxPos);
+    }
     //log::log("Ship " + ship->position.toString() + " ==> " + maxPos.toString());
-    vector<Direction> targetDirs = gameMap_->get_unsafe_moves(shipPos, maxPos);
+    gameMap_->add_unsafe_moves(shipPos, maxPos, targetDirs);
     sort(targetDirs.begin(), targetDirs.end(), directionHasGreaterHaliteCmp);
 
     // add some wiggle
-    vector<Direction> wiggleDirs = wiggleDirectionsMostHalite(ship);
-    targetDirs.push_back(wiggleDirs[0]);
+    if (shouldWiggle()) {
+        array<Direction, 4> wiggleDirs = wiggleDirectionsMostHalite(ship);
+        targetDirs.push_back(wiggleDirs[0]);
+    }
     return targetDirs;
 }
 
-vector<Direction> Navigator::newShip(shared_ptr<Ship> ship) {
-    vector<Direction> nextDirs = explore(ship);
-    vector<Direction> wiggleDirs = wiggleDirectionsMostHalite(ship);
+pmr::vector<Direction> Navigator::newShip(Ship* ship) {
+    pmr::vector<Direction> nextDirs = explore(ship);
+    // a new ship sits on a dropoff, so it always needs somewhere to go
+    array<Direction, 4> wiggleDirs = wiggleDirectionsMostHalite(ship);
     nextDirs.insert(nextDirs.end(), wiggleDirs.begin(), wiggleDirs.end());
     return nextDirs;
 }
 
-vector<Direction> Navigator::dropoffHalite(shared_ptr<Ship> ship) {
+pmr::vector<Direction> Navigator::dropoffHalite(Ship* ship) {
     // go to the closest shipyard or dropoffs.
-    vector<Position> targetPositions;
-    targetPositions.push_back(me_->shipyard->position);
-    for (auto dropoffpair : me_->dropoffs) {
-        Position dropoffPos = dropoffpair.second->position;
-        targetPositions.push_back(dropoffPos);
-    }
-
-    Position targetPosition = targetPositions[0];
-    for (Position currentPosition : targetPositions) {
+    Position targetPosition = me_->shipyard->position;
+    for (const auto& dropoffpair : me_->dropoffs) {
+        Position currentPosition = dropoffpair.second->position;
         if (gameMap_->calculate_distance(ship->position, currentPosition) < gameMap_->calculate_distance(ship->position, targetPosition)) {
             targetPosition = currentPosition;
         }
     }
 
-    vector<Direction> nextDirs = gameMap_->get_unsafe_moves(ship->position, targetPosition);
-    DirectionHasLessHaliteCmp directionHasLessHaliteCmp = DirectionHasLessHaliteCmp(gameMap_, ship);
+    pmr::vector<Direction> nextDirs(memory_);
+    gameMap_->add_unsafe_moves(ship->position, targetPosition, nextDirs);
+    DirectionHasLessHaliteCmp directionHasLessHaliteCmp = DirectionHasLessHaliteCmp(*gameMap_, ship);
     sort(nextDirs.begin(), nextDirs.end(), directionHasLessHaliteCmp);
 
-    vector<Direction> wiggleDirs = wiggleDirectionsMostHalite(ship);
-    sort(wiggleDirs.begin(), wiggleDirs.end(), directionHasLessHaliteCmp);
-    nextDirs.push_back(wiggleDirs[0]);
-    nextDirs.push_back(wiggleDirs[1]);
+    if (shouldWiggle()) {
+        array<Direction, 4> wiggleDirs = wiggleDirectionsMostHalite(ship);
+        sort(wiggleDirs.begin(), wiggleDirs.end(), directionHasLessHaliteCmp);
+        nextDirs.push_back(wiggleDirs[0]);
+        nextDirs.push_back(wiggleDirs[1]);
+    }
     return nextDirs;
 }
 
-vector<Direction> Navigator::wiggleDirectionsMostHalite(shared_ptr<Ship> ship) {
-    vector<Direction> shuffledDirs = vector<Direction>(ALL_CARDINALS.begin(), ALL_CARDINALS.end());
+array<Direction, 4> Navigator::wiggleDirectionsMostHalite(Ship* ship) {
+    array<Direction, 4> shuffledDirs = ALL_CARDINALS;
     shuffle(shuffledDirs.begin(), shuffledDirs.end(), rng_);
 
-    DirectionHasGreaterHaliteCmp directionHasGreaterHaliteCmp = DirectionHasGreaterHaliteCmp(gameMap_, ship);
+    DirectionHasGreaterHaliteCmp directionHasGreaterHaliteCmp = DirectionHasGreaterHaliteCmp(*gameMap_, ship);
     sort(shuffledDirs.begin(), shuffledDirs.end(), directionHasGreaterHaliteCmp);
     return shuffledDirs;
 }
 
 /// Exploring ship nearby and potentially do not know what to do
-bool Navigator::confusedExploringShipNearby(shared_ptr<Ship> ship) {
+bool Navigator::confusedExploringShipNearby(Ship* ship) {
     for (Direction direction : ALL_CARDINALS) {
         Position nearPos = gameMap_->destination_position(ship->position, direction);
-        if (gameMap_->at(nearPos)->is_occupied()) {
-            shared_ptr<Ship> nearShip = gameMap_->at(nearPos)->ship;
+        if (gameMap_->at(nearPos).is_occupied()) {
+            Ship* nearShip = gameMap_->at(nearPos).ship();
             // if it is our ship
             if (nearShip->owner == me_->id) {
                 assert(shipStatus_.count(nearShip->id));
@@ -205,7 +375,7 @@ bool Navigator::confusedExploringShipNearby(shared_ptr<Ship> ship) {
                 // position, then return true
                 if ((shipStatus_[nearShip->id] == ShipStatus::EXPLORE or
                      shipStatus_[nearShip->id] == ShipStatus::NEW) and
-                    gameMap_->at(ship->position)->halite > gameMap_->at(nearShip->position)->halite) {
+                    gameMap_->at(ship->position).halite > gameMap_->at(nearShip->position).halite) {
                         return true;
                     }
             }
@@ -214,18 +384,18 @@ bool Navigator::confusedExploringShipNearby(shared_ptr<Ship> ship) {
     return false;
 }
 
-vector<Direction> Navigator::collect(shared_ptr<Ship> ship) {
+pmr::vector<Direction> Navigator::collect(Ship* ship) {
+    pmr::vector<Direction> outDirs(memory_);
     // if there is another exploring ship close by, create a space for it.
     if (confusedExploringShipNearby(ship)) {
-        vector<Direction> outDirs;
-        vector<Direction> targetDirs = wiggleDirectionsMostHalite(ship);
-        for (Direction direction : targetDirs) {
+        for (Direction direction : wiggleDirectionsMostHalite(ship)) {
             Position targetPos = gameMap_->destination_position(ship->position, direction);
-            if (gameMap_->at(targetPos)->halite > gameMap_->at(ship)->halite) {
+            if (gameMap_->at(targetPos).halite > gameMap_->at(ship).halite) {
                 outDirs.push_back(direction);
             }
         }
         return outDirs;
     }
-    return { Direction::STILL };
+    outDirs.push_back(Direction::STILL);
+    return outDirs;
 }
\ No newline at end of file
@@ -5,11 +5,21 @@
 #include "hlt/ship.hpp"
 #include "hlt/dropoff.hpp"
 #include "hlt/game.hpp"
+#include "hlt/distance_field.hpp"
 #include "hlt/constants.hpp"
 #include "shipStatus.hpp"
-
+#include "turn_budget.hpp"
+#include "tunables.hpp"
+#include "potential_field.hpp"
+#include "assignment.hpp"
+#include "work_stealing_pool.hpp"
+
+#include <array>
+#include <cstdint>
+#include <memory_resource>
 #include <random>
 #include <set>
+#include <unordered_map>
 
 using namespace std;
 using namespace hlt;
@@ -20,20 +30,56 @@ using namespace hlt;
 /// explore or return home). -- It will (1) return a direction or
 class Navigator {
 public:
-    Navigator(shared_ptr<GameMap>& gameMap, shared_ptr<Player>& me, 
-              unordered_map<EntityId, ShipStatus>& shipStatus, mt19937& rng);
-    vector<Direction> explore(shared_ptr<Ship> ship);
-    vector<Direction> collect(shared_ptr<Ship> ship);
-    vector<Direction> dropoffHalite(shared_ptr<Ship> ship);
-    vector<Direction> newShip(shared_ptr<Ship> ship);
+    /// exploreTargets keeps each ship's explore target (a cell index) between
+    /// turns, so that a turn running out of time can keep following it.
+    /// potentialField is kept between turns too, and brought up to date here.
+    /// Everything the navigator allocates, the direction lists it returns
+    /// included, comes from memory (the bot's TurnArena), so the navigator
+    /// and its results only live for the turn.
+    /// With a pool, planExploreTargets scores the ships on its threads as well
+    /// as the calling one; without, everything runs on the calling thread.
+    Navigator(shared_ptr<GameMap>& gameMap, shared_ptr<Player>& me, const OccupancyBoards& boards,
+              pmr::unordered_map<EntityId, ShipStatus>& shipStatus, mt19937& rng,
+              pmr::unordered_map<EntityId, int>& exploreTargets, PotentialField& potentialField,
+              TurnBudget& budget, const GameTunables& tunables, WorkStealingPool* pool,
+              pmr::memory_resource* memory);
+    pmr::vector<Direction> explore(Ship* ship);
+    pmr::vector<Direction> collect(Ship* ship);
+    pmr::vector<Direction> dropoffHalite(Ship* ship);
+    pmr::vector<Direction> newShip(Ship* ship);
+    /// Assign explore targets to all these ships at once; explore() then
+    /// follows the assigned target instead of picking one greedily.
+    /// Ships keep last turn's target until something happens to it, and only
+    /// the others search for a new one. The search is spread over the pool;
+    /// the targets are handed out on the calling thread, in ship order, so they
+    /// do not depend on the number of threads.
+    void planExploreTargets(const pmr::vector<Ship*>& ships);
     int getPickUpThreshold() { return lowestHaliteToCollect_; }
 
+    /// Size the calling thread's search buffers for the largest explore window
+    /// on a map this wide, so that planning on it never allocates. Call on
+    /// every thread that plans, before its first turn.
+    static void reserveThreadScratch(int mapWidth);
+
 private:
     shared_ptr<GameMap> gameMap_;
     shared_ptr<Player> me_;
+    const OccupancyBoards& boards_;
     vector<vector<Halite>> bestReturnRoute_;
-    unordered_map<EntityId, ShipStatus>& shipStatus_;
-    set<Position> usedPosiitons_;
+    pmr::unordered_map<EntityId, ShipStatus>& shipStatus_;
+    pmr::set<Position> usedPosiitons_;
+    // ship id -> cell index picked by planExploreTargets
+    pmr::unordered_map<EntityId, int> assignedTargets_;
+    pmr::unordered_map<EntityId, int>& exploreTargets_;
+    PotentialField& potentialField_;
+    TurnBudget& budget_;
+    const GameTunables& tunables_;
+
+    static const int NO_EXPLORE_TARGET = -1;
+    static const size_t EXPLORE_CANDIDATES = 32;
+    static const int ASSIGNMENT_BUDGET_MS = 50;
+    // how far explore windows may grow once the turn is running late
+    static const int REDUCED_LOOK_AHEAD = Tunables::SHIP_LOOKS_AHEAD * 2;
 
     // what is the highest halite potential (halite/turn) in this map
     double maxHalitePotential_;
@@ -43,42 +89,48 @@ private:
     int lowestHaliteToCollect_;
 
     mt19937& rng_;
+    WorkStealingPool* pool_;
+    pmr::memory_resource* memory_;
+
+    /// How the search for a ship's explore candidates ended.
+    enum class CandidateSearch : uint8_t {
+        FOUND,      // the ship has candidates, though maybe none left untaken
+        NO_WINDOW,  // no window around the ship holds a cell worth going to
+        OUT_OF_TIME // the turn ran out of time before the search
+    };
 
+    // The comparators are copied freely by the standard algorithms, so they
+    // only hold references.
     struct PositionHasLessHaliteCmp
     {
-        PositionHasLessHaliteCmp(shared_ptr<GameMap> gameMap) {
-            gameMap_ = gameMap;
-        }
+        PositionHasLessHaliteCmp(GameMap& gameMap) : gameMap_(gameMap) {}
 
-        shared_ptr<GameMap> gameMap_;
+        GameMap& gameMap_;
 
         bool operator()(const Position& a, const Position& b) const
         {
-            return gameMap_->at(a)->halite < gameMap_->at(b)->halite;
+            return gameMap_.halite[gameMap_.index(a)] < gameMap_.halite[gameMap_.index(b)];
         }
     };
 
     struct DirectionHasLessHaliteCmp
     {
-        DirectionHasLessHaliteCmp(shared_ptr<GameMap> gameMap, shared_ptr<Ship> ship) {
-            gameMap_ = gameMap;
-            ship_ = ship;
-        }
+        DirectionHasLessHaliteCmp(GameMap& gameMap, Ship* ship) : gameMap_(gameMap), ship_(ship) {}
 
-        shared_ptr<GameMap> gameMap_;
-        shared_ptr<Ship> ship_;
+        GameMap& gameMap_;
+        Ship* ship_;
 
         bool operator()(const Direction& a, const Direction& b) const
         {
-            Position posA = gameMap_->destination_position(ship_->position, a);
-            Position posB = gameMap_->destination_position(ship_->position, b);
-            return gameMap_->at(posA)->halite < gameMap_->at(posB)->halite;
+            Position posA = gameMap_.destination_position(ship_->position, a);
+            Position posB = gameMap_.destination_position(ship_->position, b);
+            return gameMap_.halite[gameMap_.index(posA)] < gameMap_.halite[gameMap_.index(posB)];
         }
     };
 
     struct DirectionHasGreaterHaliteCmp
     {
-        DirectionHasGreaterHaliteCmp(shared_ptr<GameMap> gameMap, shared_ptr<Ship> ship) :
+        DirectionHasGreaterHaliteCmp(GameMap& gameMap, Ship* ship) :
             directionHasLessHaliteCmp_(gameMap, ship) {}
         
         bool operator()(const Direction& a, const Direction& b) const
@@ -91,19 +143,23 @@ private:
 
     struct LessFavorablePositionCmp
     {
-        LessFavorablePositionCmp(shared_ptr<GameMap> gameMap,
-                                  vector<Position> centerPositions,
+        LessFavorablePositionCmp(GameMap& gameMap,
+                                  const DistanceField& homeDistance,
+                                  const PotentialField& potentialField,
                                   Position shipPos,
-                                  double halitePotentialNavigateThreshold);
+                                  double halitePotentialNavigateThreshold,
+                                  const GameTunables& tunables);
 
-        shared_ptr<GameMap> gameMap_;
-        vector<Position> centerPositions_;
+        GameMap& gameMap_;
+        const DistanceField& homeDistance_;
+        const PotentialField& potentialField_;
         Position shipPos_;
         double halitePotentialNavigateThreshold_;
-        vector<pair<Direction, int>> directionalPenalty_;
+        double hltCorr0_;
+        double hltCorr1_;
 
         double evaluatePosition(Position pos) const;
-        bool noValidPosition(vector<Position> posList) const;
+        bool noValidPosition(const pmr::vector<Position>& posList) const;
 
         bool operator()(const Position& a, const Position& b) const {
             double valA = evaluatePosition(a);
@@ -112,11 +168,22 @@ private:
         }
     };
 
-    vector<Direction> wiggleDirectionsMostHalite(shared_ptr<Ship> ship);
-    bool confusedExploringShipNearby(shared_ptr<Ship> ship);
-    vector<Position> getSurroundingPositions(Position middlePos, int lookAhead);
+    /// The four cardinal directions, most halite first; ties are broken at random.
+    array<Direction, 4> wiggleDirectionsMostHalite(Ship* ship);
+    bool confusedExploringShipNearby(Ship* ship);
+    /// Fill posList with the cells within lookAhead of middlePos.
+    void getSurroundingPositions(Position middlePos, int lookAhead, pmr::vector<Position>& posList);
+    bool windowMayHaveValidPosition(Position middlePos, int lookAhead);
+    bool findExploreWindow(Position shipPos, const LessFavorablePositionCmp& posFavCmp,
+                           pmr::vector<Position>& posList);
+    bool cachedExploreTarget(Ship* ship, int& target);
+    bool keepsExploreTarget(Ship* ship, const LessFavorablePositionCmp& posFavCmp, int& target);
+    /// Put the ship's best EXPLORE_CANDIDATES cells, not taken by another ship,
+    /// into candidates, which must have room for them. Only reads the
+    /// navigator and the map, so several ships can be scored at once.
+    CandidateSearch findExploreCandidates(Ship* ship, pmr::vector<AssignmentCandidate>& candidates);
+    bool shouldWiggle();
 
-    double calculateMaxHalitePotential();
     double calculateHalitePotentialNavigateThreshold(double maxHalitePotential);
     int calculateLowestHaliteToCollect();
 
@@ -0,0 +1,179 @@
+#include "potential_field.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+using namespace hlt;
+
+/// A cell worth more than three times its neighbours' average only got there
+/// through a collision, and will likely be gone before a ship arrives.
+static int clampOutlier(int cellHalite, int surroundingSum) {
+    const int surroundingHalite = surroundingSum / 4;
+    return cellHalite > surroundingHalite * 3 ? surroundingHalite : cellHalite;
+}
+
+#if defined(__SSE2__)
+/// Stores numerator / (denominator * corr0 + corr1) of four ints to out, and
+/// returns maxSoFar raised to the largest of them. A NaN is never picked up,
+/// like with the scalar comparison.
+static __m128d storeQuotients(__m128i numerator, __m128i denominator, __m128d corr0, __m128d corr1,
+                              double* out, __m128d maxSoFar) {
+    const __m128d low = _mm_div_pd(_mm_cvtepi32_pd(numerator),
+                                   _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(denominator), corr0), corr1));
+    const __m128i highNumerator = _mm_shuffle_epi32(numerator, _MM_SHUFFLE(1, 0, 3, 2));
+    const __m128i highDenominator = _mm_shuffle_epi32(denominator, _MM_SHUFFLE(1, 0, 3, 2));
+    const __m128d high = _mm_div_pd(_mm_cvtepi32_pd(highNumerator),
+                                    _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(highDenominator), corr0), corr1));
+    _mm_storeu_pd(out, low);
+    _mm_storeu_pd(out + 2, high);
+    return _mm_max_pd(high, _mm_max_pd(low, maxSoFar));
+}
+#endif
+
+void PotentialField::update(const GameMap& map, const Position& shipyard, const DistanceField& homeDistance,
+                            double hltCorr0, double hltCorr1) {
+    const bool fresh = potential_.size() == size_t(map.width) * map.height &&
+                       mapUpdate_ + 1 == map.update_count &&
+                       shipyardX_ == shipyard.x && shipyardY_ == shipyard.y &&
+                       homeSources_ == homeDistance.source_count &&
+                       hltCorr0_ == hltCorr0 && hltCorr1_ == hltCorr1;
+    mapUpdate_ = map.update_count;
+    shipyardX_ = shipyard.x;
+    shipyardY_ = shipyard.y;
+    homeSources_ = homeDistance.source_count;
+    hltCorr0_ = hltCorr0;
+    hltCorr1_ = hltCorr1;
+    // with a negative hltCorr0 a longer trip could score higher
+    boundHolds_ = hltCorr0 >= 0 && hltCorr1 > 0;
+    if (!fresh) {
+        compute(map, homeDistance);
+        return;
+    }
+
+    const int width = map.width;
+    const int height = map.height;
+    for (int cell : map.changed_cells) {
+        // the outlier clamp of the neighbours looks at this cell too
+        const int x = cell % width;
+        const int y = cell / width;
+        refreshCell(map, homeDistance, cell);
+        refreshCell(map, homeDistance, y * width + (x + 1) % width);
+        refreshCell(map, homeDistance, y * width + (x + width - 1) % width);
+        refreshCell(map, homeDistance, ((y + 1) % height) * width + x);
+        refreshCell(map, homeDistance, ((y + height - 1) % height) * width + x);
+    }
+    maxPotential_ = 1;
+    for (int y = 0; y < height; y++) {
+        if (rowStale_[y]) {
+            rowStale_[y] = 0;
+            rowMax_[y] = 1;
+            for (int x = 0; x < width; x++) {
+                if (potential_[y * width + x] > rowMax_[y]) {
+                    rowMax_[y] = potential_[y * width + x];
+                }
+            }
+        }
+        maxPotential_ = max(maxPotential_, rowMax_[y]);
+    }
+}
+
+void PotentialField::compute(const GameMap& map, const DistanceField& homeDistance) {
+    const int width = map.width;
+    const int height = map.height;
+    potential_.resize(size_t(width) * height);
+    exploreBound_.resize(size_t(width) * height);
+    rowMax_.assign(height, 1);
+    rowStale_.assign(height, 0);
+    paddedRow_.resize(width + 2);
+
+    for (int y = 0; y < height; y++) {
+        int x = 0;
+#if defined(__SSE2__)
+        const Halite* row = &map.halite[size_t(y) * width];
+        paddedRow_[0] = row[width - 1];
+        copy(row, row + width, paddedRow_.begin() + 1);
+        paddedRow_[width + 1] = row[0];
+        const Halite* north = &map.halite[size_t((y + height - 1) % height) * width];
+        const Halite* south = &map.halite[size_t((y + 1) % height) * width];
+        // dx[x] is the distance between column x and the shipyard's
+        const int* dx = &map.delta_x[3 * width - shipyardX_];
+        const int* home = &homeDistance.distance[size_t(y) * width];
+        double* potential = &potential_[size_t(y) * width];
+        double* bound = &exploreBound_[size_t(y) * width];
+        const __m128i dyVector = _mm_set1_epi32(map.delta_y[y - shipyardY_ + 3 * height]);
+        const __m128i cap = _mm_set1_epi32(EXPLORE_HALITE_CAP);
+        const __m128d corr0 = _mm_set1_pd(hltCorr0_);
+        const __m128d corr1 = _mm_set1_pd(hltCorr1_);
+        __m128d maxVector = _mm_set1_pd(rowMax_[y]);
+        for (; x + 4 <= width; x += 4) {
+            const __m128i cell = _mm_loadu_si128((const __m128i*)(row + x));
+            __m128i sum = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(north + x)),
+                                        _mm_loadu_si128((const __m128i*)(south + x)));
+            sum = _mm_add_epi32(sum, _mm_loadu_si128((const __m128i*)(&paddedRow_[x])));
+            sum = _mm_add_epi32(sum, _mm_loadu_si128((const __m128i*)(&paddedRow_[x + 2])));
+            // halite is never negative, so the shift divides like clampOutlier does
+            const __m128i surrounding = _mm_srai_epi32(sum, 2);
+            const __m128i outlier = _mm_cmpgt_epi32(cell, _mm_add_epi32(surrounding, _mm_slli_epi32(surrounding, 1)));
+            const __m128i clamped = _mm_or_si128(_mm_and_si128(outlier, surrounding), _mm_andnot_si128(outlier, cell));
+            const __m128i distance = _mm_add_epi32(dyVector, _mm_loadu_si128((const __m128i*)(dx + x)));
+            const __m128i twiceDistance = _mm_add_epi32(distance, distance);
+            const __m128i overCap = _mm_cmpgt_epi32(cell, cap);
+            const __m128i capped = _mm_or_si128(_mm_and_si128(overCap, cap), _mm_andnot_si128(overCap, cell));
+            const __m128i homeDistances = _mm_loadu_si128((const __m128i*)(home + x));
+
+            maxVector = storeQuotients(clamped, twiceDistance, corr0, corr1, potential + x, maxVector);
+            storeQuotients(capped, homeDistances, corr0, corr1, bound + x, maxVector);
+        }
+        double lanes[2];
+        _mm_storeu_pd(lanes, maxVector);
+        rowMax_[y] = max(lanes[0], lanes[1]);
+#endif
+        // without SSE2 the whole row, else the cells after the last group of four
+        for (; x < width; x++) {
+            computeCell(map, homeDistance, x, y);
+            if (potential_[y * width + x] > rowMax_[y]) {
+                rowMax_[y] = potential_[y * width + x];
+            }
+        }
+    }
+
+    if (!boundHolds_) {
+        fill(exploreBound_.begin(), exploreBound_.end(), numeric_limits<double>::infinity());
+    }
+    maxPotential_ = 1;
+    for (int y = 0; y < height; y++) {
+        maxPotential_ = max(maxPotential_, rowMax_[y]);
+    }
+}
+
+void PotentialField::refreshCell(const GameMap& map, const DistanceField& homeDistance, int cell) {
+    const int y = cell / map.width;
+    const double previous = potential_[cell];
+    computeCell(map, homeDistance, cell % map.width, y);
+    if (potential_[cell] > rowMax_[y]) {
+        rowMax_[y] = potential_[cell];
+    }
+    else if (previous == rowMax_[y] && !(potential_[cell] >= previous)) {
+        rowStale_[y] = 1;
+    }
+}
+
+void PotentialField::computeCell(const GameMap& map, const DistanceField& homeDistance, int x, int y) {
+    const int width = map.width;
+    const int height = map.height;
+    const int cell = y * width + x;
+    const vector<Halite>& halite = map.halite;
+    const int surroundingSum = halite[((y + height - 1) % height) * width + x] + halite[((y + 1) % height) * width + x] +
+                               halite[y * width + (x + 1) % width] + halite[y * width + (x + width - 1) % width];
+    const int clamped = clampOutlier(halite[cell], surroundingSum);
+    const int distance = map.delta_x[x - shipyardX_ + 3 * width] + map.delta_y[y - shipyardY_ + 3 * height];
+    potential_[cell] = clamped / (2 * distance * hltCorr0_ + hltCorr1_);
+    exploreBound_[cell] = boundHolds_ ?
+        min(halite[cell], EXPLORE_HALITE_CAP) / (homeDistance.distance[cell] * hltCorr0_ + hltCorr1_) :
+        numeric_limits<double>::infinity();
+}
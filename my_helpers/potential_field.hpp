@@ -0,0 +1,65 @@
+#pragma once
+
+#include "hlt/game_map.hpp"
+#include "hlt/distance_field.hpp"
+#include "hlt/position.hpp"
+
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+using namespace hlt;
+
+/// The halite potential (halite per turn of travel) of every cell. It lives
+/// for the whole game: each turn only the cells whose halite changed, and
+/// their neighbours, are recomputed. A full pass over the flat halite array,
+/// four cells at a time where SSE2 is available, is only needed when the map,
+/// our dropoffs or the tunables change under it. All paths give bit-identical
+/// results.
+class PotentialField {
+public:
+    /// Bring the field up to date with the map's latest frame.
+    /// shipyard: where the navigation potential is measured from.
+    /// homeDistance: the distance every ship's trip home is scored with.
+    void update(const GameMap& map, const Position& shipyard, const DistanceField& homeDistance,
+                double hltCorr0, double hltCorr1);
+
+    /// The highest potential on the map, and at least 1.
+    double maxPotential() const { return maxPotential_; }
+
+    /// Halite of the cell over the round trip from the shipyard; halite far
+    /// above the neighbours' (a collision wreck) counts as theirs.
+    double potential(int cell) const { return potential_[cell]; }
+
+    /// No ship scores the cell higher than this in LessFavorablePositionCmp:
+    /// the capped halite over the trip home alone, as the ship's own distance
+    /// can only add to the divisor. Infinite if the tunables make that untrue.
+    double exploreBound(int cell) const { return exploreBound_[cell]; }
+
+    /// Halite above this is not counted when scoring explore targets.
+    static constexpr int EXPLORE_HALITE_CAP = 800;
+
+private:
+    /// Recompute every cell.
+    void compute(const GameMap& map, const DistanceField& homeDistance);
+
+    /// Recompute one cell, keeping its row's maximum up to date.
+    void refreshCell(const GameMap& map, const DistanceField& homeDistance, int cell);
+    void computeCell(const GameMap& map, const DistanceField& homeDistance, int x, int y);
+
+    vector<double> potential_;
+    vector<double> exploreBound_;
+    vector<double> rowMax_;    // per row: the highest potential, and at least 1
+    vector<uint8_t> rowStale_; // the row's highest potential went down, rowMax_ needs a rescan
+    vector<Halite> paddedRow_; // a row with its wrapped-around neighbours at both ends
+    double maxPotential_ = 1;
+
+    // what the field was last computed from
+    int mapUpdate_ = -1;
+    int shipyardX_ = -1;
+    int shipyardY_ = -1;
+    int homeSources_ = 0;
+    double hltCorr0_ = 0;
+    double hltCorr1_ = 0;
+    bool boundHolds_ = true;
+};
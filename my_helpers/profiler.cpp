@@ -0,0 +1,137 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static const int SECTION_COUNT = static_cast<int>(ProfileSection::COUNT);
+// bucket b holds per-turn times in [2^(b-1), 2^b) microseconds, bucket 0 holds 0
+static const int HISTOGRAM_BUCKETS = 24;
+
+struct TurnProfile {
+    int turnNumber;
+    array<long long, SECTION_COUNT> nanoseconds;
+    array<int, SECTION_COUNT> calls;
+    array<long long, SECTION_COUNT> allocations;
+};
+
+static int botId_ = -1;
+static bool dumped_ = false;
+static TurnProfile current_ = {};
+static vector<TurnProfile> turns_;
+
+static void dumpAtExit() {
+    Profiler::dump();
+}
+
+static int histogramBucket(long long nanoseconds) {
+    long long microseconds = nanoseconds / 1000;
+    int bucket = 0;
+    while (microseconds > 0 && bucket < HISTOGRAM_BUCKETS - 1) {
+        microseconds >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+const char* Profiler::sectionName(ProfileSection section) {
+    switch (section) {
+#define PROFILE_SECTION_NAME_ENTRY(name) case ProfileSection::name: return #name;
+        PROFILE_SECTION_LIST(PROFILE_SECTION_NAME_ENTRY)
+#undef PROFILE_SECTION_NAME_ENTRY
+        default: return "unknown";
+    }
+}
+
+void Profiler::open(int botId) {
+    if (botId_ == -1) {
+        atexit(dumpAtExit);
+    }
+    botId_ = botId;
+}
+
+void Profiler::record(ProfileSection section, chrono::nanoseconds duration, long long allocations) {
+    // only the bot itself profiles; bots inside a simulator are not opened
+    if (botId_ == -1) {
+        return;
+    }
+    int index = static_cast<int>(section);
+    current_.nanoseconds[index] += duration.count();
+    current_.calls[index]++;
+    current_.allocations[index] += allocations;
+}
+
+void Profiler::endTurn(int turnNumber) {
+    current_.turnNumber = turnNumber;
+    turns_.push_back(current_);
+    current_ = {};
+}
+
+void Profiler::dump() {
+    if (botId_ == -1 || dumped_) {
+        return;
+    }
+    dumped_ = true;
+    string prefix = "profile-" + to_string(botId_);
+    // allocation columns only mean something when operator new is counted
+    const bool allocations = AllocTracker::enabled();
+
+    ofstream csv(prefix + ".csv", ios::trunc | ios::out);
+    csv << "turn";
+    for (int s = 0; s < SECTION_COUNT; s++) {
+        const char* name = sectionName(static_cast<ProfileSection>(s));
+        csv << "," << name << "_us," << name << "_calls";
+        if (allocations) {
+            csv << "," << name << "_allocs";
+        }
+    }
+    csv << "\n";
+    for (const TurnProfile& turn : turns_) {
+        csv << turn.turnNumber;
+        for (int s = 0; s < SECTION_COUNT; s++) {
+            csv << "," << turn.nanoseconds[s] / 1000 << "," << turn.calls[s];
+            if (allocations) {
+                csv << "," << turn.allocations[s];
+            }
+        }
+        csv << "\n";
+    }
+
+    ofstream json(prefix + ".json", ios::trunc | ios::out);
+    json << "{\"turns\":" << turns_.size() << ",\"sections\":{";
+    for (int s = 0; s < SECTION_COUNT; s++) {
+        long long total = 0;
+        long long worst = 0;
+        long long calls = 0;
+        long long allocated = 0;
+        long long worstAllocated = 0;
+        array<int, HISTOGRAM_BUCKETS> histogram = {};
+        for (const TurnProfile& turn : turns_) {
+            total += turn.nanoseconds[s];
+            worst = max(worst, turn.nanoseconds[s]);
+            calls += turn.calls[s];
+            allocated += turn.allocations[s];
+            worstAllocated = max(worstAllocated, turn.allocations[s]);
+            histogram[histogramBucket(turn.nanoseconds[s])]++;
+        }
+        json << (s ? "," : "") << "\"" << sectionName(static_cast<ProfileSection>(s)) << "\":{"
+             << "\"total_us\":" << total / 1000
+             << ",\"mean_us\":" << (turns_.empty() ? 0 : total / 1000 / (long long)turns_.size())
+             << ",\"max_us\":" << worst / 1000
+             << ",\"calls\":" << calls;
+        if (allocations) {
+            json << ",\"allocs\":" << allocated << ",\"max_allocs\":" << worstAllocated;
+        }
+        json << ",\"histogram_log2_us\":[";
+        for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+            json << (b ? "," : "") << histogram[b];
+        }
+        json << "]}";
+    }
+    json << "}}\n";
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "alloc_tracker.hpp"
+
+#include <chrono>
+#include <string>
+
+using namespace std;
+
+// The hot paths we time. Listing a section here is what makes
+// ProfileSection::name exist and gives it a column in the report.
+#define PROFILE_SECTION_LIST(X) \
+    X(updateFrame)              \
+    X(adjustState)              \
+    X(navigatorInit)            \
+    X(planExploreTargets)       \
+    X(explore)                  \
+    X(resolveAllConflicts)      \
+    X(endTurn)                  \
+    X(turn)
+
+enum class ProfileSection {
+#define PROFILE_SECTION_ENUM_ENTRY(name) name,
+    PROFILE_SECTION_LIST(PROFILE_SECTION_ENUM_ENTRY)
+#undef PROFILE_SECTION_ENUM_ENTRY
+    COUNT
+};
+
+/// Collects how long each section takes per turn, and how many heap
+/// allocations it makes when AllocTracker is counting.
+/// Turns are written to profile-<id>.csv, and a summary with a histogram of
+/// the per-turn times of every section to profile-<id>.json, when the bot exits.
+class Profiler {
+public:
+    /// Start profiling; the report files are named after the bot id.
+    static void open(int botId);
+
+    /// Add one timed run of a section to the current turn.
+    static void record(ProfileSection section, chrono::nanoseconds duration, long long allocations);
+
+    /// Close the current turn and start the next one.
+    static void endTurn(int turnNumber);
+
+    /// Write the report files. Called at exit, but can be called earlier.
+    static void dump();
+
+    static const char* sectionName(ProfileSection section);
+};
+
+/// Times the enclosing scope into a profiler section.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(ProfileSection section) :
+        section_(section), allocations_(AllocTracker::allocations()), start_(chrono::steady_clock::now()) {}
+
+    ~ScopedTimer() {
+        Profiler::record(section_, chrono::steady_clock::now() - start_, AllocTracker::allocations() - allocations_);
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    ProfileSection section_;
+    long long allocations_;
+    chrono::steady_clock::time_point start_;
+};
+
+// Build with -DMYBOT_PROFILE=ON to turn the timers on; otherwise they compile
+// to nothing, so they can stay on the hot paths.
+#ifdef MYBOT_PROFILE
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(section) ScopedTimer PROFILE_CONCAT(profileTimer_, __LINE__)(ProfileSection::section)
+#define PROFILE_OPEN(botId) Profiler::open(botId)
+#define PROFILE_END_TURN(turnNumber) Profiler::endTurn(turnNumber)
+#else
+#define PROFILE_SCOPE(section) ((void)0)
+#define PROFILE_OPEN(botId) ((void)0)
+#define PROFILE_END_TURN(turnNumber) ((void)0)
+#endif
@@ -0,0 +1,461 @@
+#include "trace.hpp"
+#include "hlt/log.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace hlt;
+
+static const char MAGIC[8] = { 'H', 'L', 'T', 'T', 'R', 'A', 'C', 'E' };
+// the file grows by at least this much at a time
+static const size_t GROW_BYTES = 1 << 20;
+
+static void putVarint(vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(uint8_t(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(uint8_t(value));
+}
+
+/// FNV-1a over a record, stored after it so a record only partly written
+/// before a crash is told apart from a complete one.
+static uint32_t checksum(const uint8_t* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static const size_t CHECKSUM_BYTES = 4;
+
+/// Small negative numbers stay small: 0, -1, 1, -2, ... become 0, 1, 2, 3, ...
+static void putSigned(vector<uint8_t>& out, int64_t value) {
+    putVarint(out, (uint64_t(value) << 1) ^ uint64_t(value >> 63));
+}
+
+/// Reads varints off a byte range, and remembers if it ran past the end.
+struct Cursor {
+    const uint8_t* at;
+    const uint8_t* end;
+    bool ok = true;
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (at == end) {
+                ok = false;
+                return 0;
+            }
+            const uint8_t byte = *at++;
+            value |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        ok = false;
+        return 0;
+    }
+
+    int64_t signedVarint() {
+        const uint64_t value = varint();
+        return int64_t(value >> 1) ^ -int64_t(value & 1);
+    }
+
+    uint8_t byte() {
+        if (at == end) {
+            ok = false;
+            return 0;
+        }
+        return *at++;
+    }
+};
+
+void TraceTurn::clear() {
+    haliteChanges.clear();
+    ships.clear();
+    targets.clear();
+    intents.clear();
+    intentDirections.clear();
+    commands.clear();
+}
+
+void TraceTurn::addCommand(const hlt::Command& command) {
+    Command parsed = { command[0], -1, Direction::STILL };
+    if (parsed.kind != 'g') {
+        const size_t idEnd = command.find(' ', 2);
+        parsed.ship = stoi(command.substr(2, idEnd - 2));
+        if (parsed.kind == 'm') {
+            parsed.direction = static_cast<Direction>(command[idEnd + 1]);
+        }
+    }
+    commands.push_back(parsed);
+}
+
+/// *************** TraceWriter ****************
+
+TraceWriter::~TraceWriter() {
+    close();
+}
+
+bool TraceWriter::open(const string& path, PlayerId playerId, const GameMap& map) {
+    close();
+#if defined(_WIN32)
+    file_ = fopen(path.c_str(), "wb");
+    if (!file_) {
+        LOG_ERROR("Could not open trace file " + path);
+        return false;
+    }
+#else
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+        LOG_ERROR("Could not open trace file " + path);
+        return false;
+    }
+#endif
+    isOpen_ = true;
+    size_ = 0;
+    lastTurn_ = 0;
+    halite_ = map.halite;
+
+    record_.assign(MAGIC, MAGIC + sizeof(MAGIC));
+    putVarint(record_, VERSION);
+    putVarint(record_, playerId);
+    putVarint(record_, map.width);
+    putVarint(record_, map.height);
+    for (Halite halite : halite_) {
+        putVarint(record_, halite);
+    }
+    append(record_);
+    return isOpen_;
+}
+
+void TraceWriter::write(const TraceTurn& turn) {
+    if (!isOpen_) {
+        return;
+    }
+    record_.clear();
+    putSigned(record_, turn.turn - lastTurn_);
+    lastTurn_ = turn.turn;
+
+    sortedChanges_.assign(turn.haliteChanges.begin(), turn.haliteChanges.end());
+    sort(sortedChanges_.begin(), sortedChanges_.end());
+    putVarint(record_, sortedChanges_.size());
+    int previous = 0;
+    for (const auto& change : sortedChanges_) {
+        putVarint(record_, change.first - previous);
+        putSigned(record_, change.second - halite_[change.first]);
+        halite_[change.first] = change.second;
+        previous = change.first;
+    }
+
+    sortedShips_.assign(turn.ships.begin(), turn.ships.end());
+    sort(sortedShips_.begin(), sortedShips_.end(),
+         [](const TraceTurn::Ship& a, const TraceTurn::Ship& b) { return a.id < b.id; });
+    putVarint(record_, sortedShips_.size());
+    previous = 0;
+    for (const TraceTurn::Ship& ship : sortedShips_) {
+        putVarint(record_, ship.id - previous);
+        putVarint(record_, ship.cell);
+        putVarint(record_, ship.halite);
+        record_.push_back(ship.status);
+        previous = ship.id;
+    }
+
+    sortedTargets_.assign(turn.targets.begin(), turn.targets.end());
+    sort(sortedTargets_.begin(), sortedTargets_.end(),
+         [](const TraceTurn::Target& a, const TraceTurn::Target& b) { return a.ship < b.ship; });
+    putVarint(record_, sortedTargets_.size());
+    previous = 0;
+    for (const TraceTurn::Target& target : sortedTargets_) {
+        putVarint(record_, target.ship - previous);
+        putVarint(record_, target.cell);
+        previous = target.ship;
+    }
+
+    // intents and commands keep their order, which is part of what happened
+    putVarint(record_, turn.intents.size());
+    previous = 0;
+    size_t direction = 0;
+    for (const TraceTurn::Intent& intent : turn.intents) {
+        putSigned(record_, intent.ship - previous);
+        record_.push_back(intent.count);
+        for (int i = 0; i < intent.count; i++) {
+            record_.push_back(static_cast<uint8_t>(turn.intentDirections[direction++]));
+        }
+        previous = intent.ship;
+    }
+
+    putVarint(record_, turn.commands.size());
+    previous = 0;
+    for (const TraceTurn::Command& command : turn.commands) {
+        record_.push_back(static_cast<uint8_t>(command.kind));
+        if (command.kind != 'g') {
+            putSigned(record_, command.ship - previous);
+            previous = command.ship;
+        }
+        if (command.kind == 'm') {
+            record_.push_back(static_cast<uint8_t>(command.direction));
+        }
+    }
+
+    length_.clear();
+    putVarint(length_, record_.size());
+    const uint32_t sum = checksum(record_.data(), record_.size());
+    for (size_t i = 0; i < CHECKSUM_BYTES; i++) {
+        record_.push_back(uint8_t(sum >> (8 * i)));
+    }
+    append(length_);
+    append(record_);
+}
+
+void TraceWriter::append(const vector<uint8_t>& bytes) {
+    if (!isOpen_) {
+        return;
+    }
+#if defined(_WIN32)
+    if (fwrite(bytes.data(), 1, bytes.size(), file_) != bytes.size()) {
+        LOG_ERROR("Could not write the trace file, stopped tracing");
+        close();
+        return;
+    }
+#else
+    if (size_ + bytes.size() > capacity_) {
+        const size_t capacity = max(size_ + bytes.size(), max(capacity_ * 2, GROW_BYTES));
+        if (data_) {
+            munmap(data_, capacity_);
+            data_ = nullptr;
+        }
+        void* mapped = MAP_FAILED;
+        if (ftruncate(fd_, capacity) == 0) {
+            mapped = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        }
+        if (mapped == MAP_FAILED) {
+            LOG_ERROR("Could not grow the trace file, stopped tracing");
+            capacity_ = 0;
+            close();
+            return;
+        }
+        data_ = static_cast<uint8_t*>(mapped);
+        capacity_ = capacity;
+    }
+    memcpy(data_ + size_, bytes.data(), bytes.size());
+#endif
+    size_ += bytes.size();
+}
+
+void TraceWriter::close() {
+    if (!isOpen_) {
+        return;
+    }
+    isOpen_ = false;
+#if defined(_WIN32)
+    fclose(file_);
+    file_ = nullptr;
+#else
+    if (data_) {
+        munmap(data_, capacity_);
+        data_ = nullptr;
+    }
+    capacity_ = 0;
+    // the mapping grows in chunks; drop what was never written
+    if (ftruncate(fd_, size_) != 0) {
+        LOG_ERROR("Could not trim the trace file");
+    }
+    ::close(fd_);
+    fd_ = -1;
+#endif
+}
+
+/// *************** TraceReader ****************
+
+TraceReader::~TraceReader() {
+    close();
+}
+
+void TraceReader::close() {
+#if defined(_WIN32)
+    contents_.clear();
+#else
+    if (mapped_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+        mapped_ = false;
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    position_ = 0;
+}
+
+bool TraceReader::open(const string& path) {
+    close();
+#if defined(_WIN32)
+    ifstream in(path, ios::binary);
+    if (!in) {
+        error_ = "cannot open " + path;
+        return false;
+    }
+    contents_.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    data_ = contents_.data();
+    size_ = contents_.size();
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error_ = "cannot open " + path;
+        return false;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size == 0) {
+        ::close(fd);
+        error_ = path + " is empty";
+        return false;
+    }
+    void* mapped = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        error_ = "cannot map " + path;
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(mapped);
+    size_ = status.st_size;
+    mapped_ = true;
+#endif
+
+    if (size_ < sizeof(MAGIC) || memcmp(data_, MAGIC, sizeof(MAGIC)) != 0) {
+        error_ = path + " is not a trace file";
+        close();
+        return false;
+    }
+    Cursor cursor = { data_ + sizeof(MAGIC), data_ + size_ };
+    const uint64_t version = cursor.varint();
+    playerId_ = PlayerId(cursor.varint());
+    width_ = int(cursor.varint());
+    height_ = int(cursor.varint());
+    if (!cursor.ok || version != TraceWriter::VERSION) {
+        error_ = path + " has an unknown trace version";
+        close();
+        return false;
+    }
+    halite_.resize(size_t(width_) * height_);
+    for (Halite& halite : halite_) {
+        halite = Halite(cursor.varint());
+    }
+    if (!cursor.ok) {
+        error_ = path + " ends inside its header";
+        close();
+        return false;
+    }
+    position_ = cursor.at - data_;
+    lastTurn_ = 0;
+    error_.clear();
+    return true;
+}
+
+bool TraceReader::next(TraceTurn& turn) {
+    turn.clear();
+    Cursor cursor = { data_ + position_, data_ + size_ };
+    // a record is never empty: a zero length is the unused end of the last
+    // chunk, left in a file whose writer was never closed
+    if (cursor.at == cursor.end || *cursor.at == 0) {
+        return false;
+    }
+    // a record cut short by a crash ends the file, without reading as a turn
+    const uint64_t length = cursor.varint();
+    bool complete = cursor.ok && length + CHECKSUM_BYTES <= size_t(cursor.end - cursor.at);
+    if (complete) {
+        const uint8_t* stored = cursor.at + length;
+        uint32_t sum = 0;
+        for (size_t i = 0; i < CHECKSUM_BYTES; i++) {
+            sum |= uint32_t(stored[i]) << (8 * i);
+        }
+        complete = sum == checksum(cursor.at, length);
+    }
+    if (!complete) {
+        error_ = "the trace is cut short after byte " + to_string(position_);
+        return false;
+    }
+    cursor.end = cursor.at + length;
+
+    turn.turn = lastTurn_ + int(cursor.signedVarint());
+    size_t count = cursor.varint();
+    int previous = 0;
+    for (size_t i = 0; i < count && cursor.ok; i++) {
+        const int cell = previous + int(cursor.varint());
+        const int64_t change = cursor.signedVarint();
+        if (cell < 0 || size_t(cell) >= halite_.size()) {
+            cursor.ok = false;
+            break;
+        }
+        halite_[cell] += Halite(change);
+        turn.haliteChanges.push_back({ cell, halite_[cell] });
+        previous = cell;
+    }
+
+    count = cursor.varint();
+    previous = 0;
+    for (size_t i = 0; i < count && cursor.ok; i++) {
+        TraceTurn::Ship ship;
+        ship.id = previous + EntityId(cursor.varint());
+        ship.cell = int(cursor.varint());
+        ship.halite = Halite(cursor.varint());
+        ship.status = cursor.byte();
+        turn.ships.push_back(ship);
+        previous = ship.id;
+    }
+
+    count = cursor.varint();
+    previous = 0;
+    for (size_t i = 0; i < count && cursor.ok; i++) {
+        TraceTurn::Target target;
+        target.ship = previous + EntityId(cursor.varint());
+        target.cell = int(cursor.varint());
+        turn.targets.push_back(target);
+        previous = target.ship;
+    }
+
+    count = cursor.varint();
+    previous = 0;
+    for (size_t i = 0; i < count && cursor.ok; i++) {
+        TraceTurn::Intent intent;
+        intent.ship = previous + EntityId(cursor.signedVarint());
+        intent.count = cursor.byte();
+        for (int d = 0; d < intent.count; d++) {
+            turn.intentDirections.push_back(static_cast<Direction>(cursor.byte()));
+        }
+        turn.intents.push_back(intent);
+        previous = intent.ship;
+    }
+
+    count = cursor.varint();
+    previous = 0;
+    for (size_t i = 0; i < count && cursor.ok; i++) {
+        TraceTurn::Command command = { char(cursor.byte()), -1, Direction::STILL };
+        if (command.kind != 'g') {
+            command.ship = previous + EntityId(cursor.signedVarint());
+            previous = command.ship;
+        }
+        if (command.kind == 'm') {
+            command.direction = static_cast<Direction>(cursor.byte());
+        }
+        turn.commands.push_back(command);
+    }
+
+    if (!cursor.ok) {
+        error_ = "corrupt trace record after byte " + to_string(position_);
+        LOG_ERROR("Corrupt trace record after byte " + to_string(position_));
+        return false;
+    }
+    position_ = cursor.end + CHECKSUM_BYTES - data_;
+    lastTurn_ = turn.turn;
+    return true;
+}
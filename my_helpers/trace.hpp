@@ -0,0 +1,155 @@
+#pragma once
+
+#include "hlt/types.hpp"
+#include "hlt/direction.hpp"
+#include "hlt/command.hpp"
+#include "hlt/game_map.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace hlt;
+
+/// What the bot saw and decided in one turn, as kept in a trace file.
+struct TraceTurn {
+    struct Ship {
+        EntityId id;
+        int cell;
+        Halite halite;
+        uint8_t status; // a ShipStatus
+    };
+
+    struct Target {
+        EntityId ship;
+        int cell;
+    };
+
+    /// The directions of intent i are intentDirections[first, first + count),
+    /// first being the sum of the counts before it.
+    struct Intent {
+        EntityId ship;
+        uint8_t count;
+    };
+
+    struct Command {
+        char kind; // 'g' spawn, 'c' make a dropoff, 'm' move
+        EntityId ship;
+        Direction direction;
+    };
+
+    int turn = 0;
+    vector<pair<int, Halite>> haliteChanges; // cell and its new halite
+    vector<Ship> ships;
+    vector<Target> targets;
+    vector<Intent> intents;
+    vector<Direction> intentDirections;
+    vector<Command> commands;
+
+    /// Empty every list, keeping their memory.
+    void clear();
+
+    /// Add a command in the engine's text form.
+    void addCommand(const hlt::Command& command);
+};
+
+/// Appends one compact record per turn to a binary trace file.
+///
+/// The file starts with a header (magic, version, player id, map size and the
+/// initial halite), followed by one record per turn: its length, the record
+/// and a checksum of it. Integers are varints; halite is stored as the change
+/// since the previous record, and cells and ids as the difference from the
+/// previous entry of their list, so a steady state turn takes a few hundred
+/// bytes. The file is memory-mapped and grown in chunks, so writing a turn is
+/// a copy into memory; on platforms without mmap it falls back to buffered
+/// writes. A file cut short by a crash reads fine up to the last complete
+/// record; the checksum keeps a record left half written from reading as a turn.
+class TraceWriter {
+public:
+    TraceWriter() = default;
+    ~TraceWriter();
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    /// Start a trace of the game on this map, before its first turn.
+    bool open(const string& path, PlayerId playerId, const GameMap& map);
+
+    void write(const TraceTurn& turn);
+
+    /// Trim the file to what was written and close it. Also done on destruction.
+    void close();
+
+    bool isOpen() const { return isOpen_; }
+
+    static const uint32_t VERSION = 2;
+
+private:
+    /// Append bytes to the file.
+    void append(const vector<uint8_t>& bytes);
+
+    bool isOpen_ = false;
+#if defined(_WIN32)
+    FILE* file_ = nullptr;
+#else
+    int fd_ = -1;
+    uint8_t* data_ = nullptr;
+    size_t capacity_ = 0; // bytes mapped
+#endif
+    size_t size_ = 0;     // bytes written
+    int lastTurn_ = 0;
+    vector<Halite> halite_; // the map as far as the file has it
+    // scratch space for write
+    vector<uint8_t> record_;
+    vector<uint8_t> length_;
+    vector<pair<int, Halite>> sortedChanges_;
+    vector<TraceTurn::Ship> sortedShips_;
+    vector<TraceTurn::Target> sortedTargets_;
+};
+
+/// Reads a trace file back turn by turn. The file is memory-mapped where
+/// possible, so mining many traces does not copy them.
+class TraceReader {
+public:
+    TraceReader() = default;
+    ~TraceReader();
+    TraceReader(const TraceReader&) = delete;
+    TraceReader& operator=(const TraceReader&) = delete;
+
+    /// Returns false, with error() saying why, if the file is not a trace.
+    bool open(const string& path);
+
+    /// Read the next turn; false at the end of the file. If the file ends
+    /// with an incomplete or corrupt record, error() says where.
+    bool next(TraceTurn& turn);
+
+    PlayerId playerId() const { return playerId_; }
+    int width() const { return width_; }
+    int height() const { return height_; }
+    /// The halite of every cell as of the last turn read.
+    const vector<Halite>& halite() const { return halite_; }
+    /// Bytes of the file, and how far reading has got.
+    size_t size() const { return size_; }
+    size_t position() const { return position_; }
+    const string& error() const { return error_; }
+
+private:
+    void close();
+
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    size_t position_ = 0;
+#if defined(_WIN32)
+    vector<uint8_t> contents_;
+#else
+    bool mapped_ = false;
+#endif
+    PlayerId playerId_ = -1;
+    int width_ = 0;
+    int height_ = 0;
+    int lastTurn_ = 0;
+    vector<Halite> halite_;
+    string error_;
+};
@@ -1,60 +1,101 @@
 #include "tunables.hpp"
+#include <iomanip>
+#include <map>
+#include <mutex>
 #include <vector>
 
-std::vector<int> Tunables::playerNums;
-std::vector<int> Tunables::mapSizes;
-std::vector<int> Tunables::haliteAs;
-int Tunables::playerNumKey_;
-int Tunables::mapSizeKey_;
-int Tunables::haltieAbundanceKey_;
-std::unordered_map<std::string, double> Tunables::tunableDict_[Tunables::PLAYER_NUMS][Tunables::MAP_SIZES][Tunables::HALITE_AS];
+static const int PLAYER_NUM_VALUES[] = {2, 4};
+static const int MAP_SIZE_VALUES[] = {32, 40, 48, 56, 64};
+static const int HALITE_A_VALUES[] = {0, 1, 2};
 
-Tunables::Tunables(std::string &pathToFolder, int playerNum, int mapSize, int haliteAbundance)
-{
-    playerNums = {2, 4};
-    mapSizes = {32, 40, 48, 56, 64};
-    haliteAs = {0, 1, 2};
+static const char* TUNABLE_NAMES[] = {
+#define TUNABLE_NAME_ENTRY(name) #name,
+    TUNABLE_LIST(TUNABLE_NAME_ENTRY)
+#undef TUNABLE_NAME_ENTRY
+};
 
-    playerNumKey_ = -1;
-    mapSizeKey_ = -1;
-    haltieAbundanceKey_ = -1;
-    for (unsigned int i = 0; i < playerNums.size(); i++) {
-        if (playerNums[i] == playerNum)
-            playerNumKey_ = i;
-    }
-    for (unsigned int i = 0; i < mapSizes.size(); i++) {
-        if (mapSizes[i] == mapSize)
-            mapSizeKey_ = i;
+const char* Tunables::tunableName(Tunable tunable) {
+    return TUNABLE_NAMES[static_cast<int>(tunable)];
+}
+
+int Tunables::tunableIndex(const std::string& name) {
+    for (int i = 0; i < TUNABLE_COUNT; i++) {
+        if (name == TUNABLE_NAMES[i]) {
+            return i;
+        }
     }
-    for (unsigned int i = 0; i < haliteAs.size(); i++) {
-        if (haliteAs[i] == haliteAbundance)
-            haltieAbundanceKey_ = i;
+    return -1;
+}
+
+std::string Tunables::csvPath(const std::string& pathToFolder, int playerNum, int mapSize, int haliteAbundance) {
+    return pathToFolder + "/csv/" + std::to_string(playerNum) + '-' +
+           std::to_string(mapSize) + '-' + std::to_string(haliteAbundance) + ".csv";
+}
+
+std::shared_ptr<const Tunables> Tunables::load(const std::string& pathToFolder) {
+    // bots simulated side by side ask for the same folder over and over
+    static std::mutex cacheLock;
+    static std::map<std::string, std::shared_ptr<const Tunables>> cache;
+    std::lock_guard<std::mutex> lock(cacheLock);
+    std::shared_ptr<const Tunables>& tunables = cache[pathToFolder];
+    if (!tunables) {
+        std::shared_ptr<Tunables> loaded(new Tunables());
+        loaded->readAllCsv(pathToFolder);
+        tunables = loaded;
     }
+    return tunables;
+}
 
-    assert(playerNumKey_ != -1);
-    assert(mapSizeKey_ != -1);
-    assert(haltieAbundanceKey_ != -1);
+void Tunables::findKeys(int playerNum, int mapSize, int haliteAbundance, int& p, int& s, int& h) {
+    p = -1;
+    s = -1;
+    h = -1;
+    for (int i = 0; i < PLAYER_NUMS; i++) {
+        if (PLAYER_NUM_VALUES[i] == playerNum)
+            p = i;
+    }
+    for (int i = 0; i < MAP_SIZES; i++) {
+        if (MAP_SIZE_VALUES[i] == mapSize)
+            s = i;
+    }
+    for (int i = 0; i < HALITE_AS; i++) {
+        if (HALITE_A_VALUES[i] == haliteAbundance)
+            h = i;
+    }
+    if (p == -1 || s == -1 || h == -1) {
+        std::cerr << "Error: no tunables for " << playerNum << " players, map size " << mapSize
+                  << " and halite abundance " << haliteAbundance << std::endl;
+        exit(1);
+    }
+}
 
-    readAllCsv(pathToFolder);
+const Tunables::TunableValues& Tunables::lookUpValues(int playerNum, int mapSize, int haliteAbundance) const {
+    int p, s, h;
+    findKeys(playerNum, mapSize, haliteAbundance, p, s, h);
+    return tunableTable_[p][s][h];
 }
 
-void Tunables::readAllCsv(std::string &pathToFolder) {
-    std::string startpath = pathToFolder + "/csv";
+std::shared_ptr<const Tunables> Tunables::withValues(int playerNum, int mapSize, int haliteAbundance,
+                                                     const TunableValues& values) const {
+    int p, s, h;
+    findKeys(playerNum, mapSize, haliteAbundance, p, s, h);
+    std::shared_ptr<Tunables> changed(new Tunables(*this));
+    changed->tunableTable_[p][s][h] = values;
+    return changed;
+}
 
-    for (unsigned int p = 0; p < playerNums.size(); p++) {
-        for (unsigned int s = 0; s < mapSizes.size(); s++) {
-            for (unsigned int h = 0; h < haliteAs.size(); h++) {
-                std::string path = startpath + '/' + std::to_string(playerNums[p]) + '-' +
-                                    std::to_string(mapSizes[s]) + '-' + std::to_string(haliteAs[h]) +
-                                    ".csv";
-                // std::cout << path << std::endl;
-                readCsvToDict(path, tunableDict_[p][s][h]);
+void Tunables::readAllCsv(const std::string& pathToFolder) {
+    for (int p = 0; p < PLAYER_NUMS; p++) {
+        for (int s = 0; s < MAP_SIZES; s++) {
+            for (int h = 0; h < HALITE_AS; h++) {
+                std::string path = csvPath(pathToFolder, PLAYER_NUM_VALUES[p], MAP_SIZE_VALUES[s], HALITE_A_VALUES[h]);
+                readCsvToDict(path, tunableTable_[p][s][h]);
             }
         }
     }
 }
 
-void Tunables::readCsvToDict(std::string filename, std::unordered_map<std::string, double> &dict) {
+void Tunables::readCsvToDict(std::string filename, TunableValues &values) {
     std::string val;
     std::ifstream file;
     file.open(filename);
@@ -75,16 +116,72 @@ void Tunables::readCsvToDict(std::string filename, std::unordered_map<std::strin
             name = val;
             getline(file, val, ',');
             value = std::stof(val);
-            dict[name] = value;
+            for (int i = 0; i < TUNABLE_COUNT; i++) {
+                if (name == TUNABLE_NAMES[i]) {
+                    values[i] = value;
+                }
+            }
             getline(file, val, ',');
             getline(file, val, ',');
             getline(file, val, ',');
             getline(file, val, ',');
             getline(file, val);
-            // std::cout << name << ' ' << dict[name] << std::endl;
+            // std::cout << name << ' ' << value << std::endl;
     }
 }
+ 
 
-double Tunables::lookUpTunable(std::string name) {
-    return tunableDict_[playerNumKey_][mapSizeKey_][haltieAbundanceKey_][name];
-} 
\ No newline at end of file
+std::vector<Tunables::CsvRow> Tunables::readCsvRows(const std::string& filename) {
+    std::vector<CsvRow> rows;
+    std::ifstream file(filename);
+    std::string line;
+    getline(file, line); // header
+    while (getline(file, line)) {
+        std::vector<std::string> fields;
+        size_t start = 0;
+        for (;;) {
+            size_t end = line.find(',', start);
+            fields.push_back(line.substr(start, end == std::string::npos ? std::string::npos : end - start));
+            if (end == std::string::npos) {
+                break;
+            }
+            start = end + 1;
+        }
+        if (fields.size() < 7) {
+            continue;
+        }
+        CsvRow row;
+        row.name = fields[0];
+        row.value = std::stod(fields[1]);
+        row.mut = std::stod(fields[2]);
+        row.min = std::stod(fields[3]);
+        row.max = std::stod(fields[4]);
+        row.type = fields[5];
+        row.remark = fields[6];
+        if (fields.size() >= 9) {
+            row.hasSpread = true;
+            row.spreadLow = std::stod(fields[7]);
+            row.spreadHigh = std::stod(fields[8]);
+        }
+        rows.push_back(row);
+    }
+    return rows;
+}
+
+void Tunables::writeCsvRows(const std::string& filename, const std::vector<CsvRow>& rows) {
+    bool hasSpread = false;
+    for (const CsvRow& row : rows) {
+        hasSpread = hasSpread || row.hasSpread;
+    }
+    std::ofstream file(filename, std::ios::trunc | std::ios::out);
+    // readCsvToDict skips everything after the value, so the extra columns are safe
+    file << "name,val,mut,min,max,type,remark" << (hasSpread ? ",spreadLow,spreadHigh" : "") << '\n';
+    for (const CsvRow& row : rows) {
+        file << row.name << ',' << std::setprecision(12) << row.value << std::setprecision(6) << ',' << row.mut << ',' << row.min << ',' << row.max << ','
+             << row.type << ',' << row.remark;
+        if (hasSpread) {
+            file << ',' << row.spreadLow << ',' << row.spreadHigh;
+        }
+        file << '\n';
+    }
+}
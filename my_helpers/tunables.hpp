@@ -5,10 +5,35 @@
 #include <tuple>
 #include <iostream>
 #include <vector>
-#include <unordered_map>
+#include <array>
+#include <string>
 #include <cassert>
+#include <memory>
 
+// Every parameter read from the csv files, by the name used in their "name" column.
+// Listing a parameter here is what makes Tunable::name exist, so a misspelled
+// lookup no longer compiles.
+#define TUNABLE_LIST(X) \
+    X(hltCorr0)         \
+    X(hltCorr1)         \
+    X(navPercent)       \
+    X(colPrecent)       \
+    X(noProdTurn)       \
+    X(shipCapStart)     \
+    X(shipCapEnd)
 
+enum class Tunable {
+#define TUNABLE_ENUM_ENTRY(name) name,
+    TUNABLE_LIST(TUNABLE_ENUM_ENTRY)
+#undef TUNABLE_ENUM_ENTRY
+    COUNT
+};
+
+/// The tunables of every csv file in a folder: one set of values per player
+/// count, map size and halite abundance.
+/// A Tunables never changes once loaded, so any number of bots, on any
+/// threads, can share one through a shared_ptr. To play with other values,
+/// make a changed copy with withValues and hand that to the bot.
 class Tunables {
 private:
     
@@ -17,28 +42,75 @@ private:
     static const int PLAYER_NUMS = 2;
     static const int MAP_SIZES = 5;
     static const int HALITE_AS = 3;
-
-    static std::vector<int> playerNums;
-    static std::vector<int> mapSizes;
-    static std::vector<int> haliteAs;
-
-    static int playerNumKey_;
-    static int mapSizeKey_;
-    static int haltieAbundanceKey_;
-
-    static std::unordered_map<std::string, double> tunableDict_[PLAYER_NUMS][MAP_SIZES][HALITE_AS];
+    static const int TUNABLE_COUNT = static_cast<int>(Tunable::COUNT);
 
 public:
+    typedef std::array<double, TUNABLE_COUNT> TunableValues;
+
+    /// A whole line of a csv file: name,val,mut,min,max,type,remark[,spreadLow,spreadHigh]
+    /// mut is the usual size of a change, min and max bound the value.
+    struct CsvRow {
+        std::string name;
+        double value;
+        double mut;
+        double min;
+        double max;
+        std::string type; // "int" or "float"
+        std::string remark;
+        // written by the optimizer: where its late iterates wandered, which is
+        // not a confidence interval on the best value
+        bool hasSpread = false;
+        double spreadLow = 0;
+        double spreadHigh = 0;
+    };
 
     // How far wil a ship look at its surroundings
     static const int SHIP_LOOKS_AHEAD = 4;
 
+    /// Read all 30 csv files in pathToFolder/csv. The files of a folder are
+    /// only read the first time; later calls share the same Tunables.
+    static std::shared_ptr<const Tunables> load(const std::string& pathToFolder);
+
+    /// The values for a player count, map size and halite abundance.
+    const TunableValues& lookUpValues(int playerNum, int mapSize, int haliteAbundance) const;
+
+    /// A copy with the values of one player count, map size and halite
+    /// abundance replaced.
+    std::shared_ptr<const Tunables> withValues(int playerNum, int mapSize, int haliteAbundance,
+                                               const TunableValues& values) const;
+
+    /// The csv name of a tunable
+    static const char* tunableName(Tunable tunable);
+    /// The index in TunableValues of a csv name, or -1
+    static int tunableIndex(const std::string& name);
+
+    /// The csv file for a player count, map size and halite abundance
+    static std::string csvPath(const std::string& pathToFolder, int playerNum, int mapSize, int haliteAbundance);
+    static std::vector<CsvRow> readCsvRows(const std::string& filename);
+    static void writeCsvRows(const std::string& filename, const std::vector<CsvRow>& rows);
+
+private:
     Tunables() {}
-    Tunables(std::string &pathToFolder, int playerNum, int mapSize, int haliteAbundance);
 
-    void readAllCsv(std::string &pathToFolder);
+    void readAllCsv(const std::string& pathToFolder);
+    static void readCsvToDict(std::string filename, TunableValues &values);
+    /// Where a bucket lives in tunableTable_; exits on a player count or map size without a csv file
+    static void findKeys(int playerNum, int mapSize, int haliteAbundance, int& p, int& s, int& h);
 
-    void readCsvToDict(std::string filename, std::unordered_map<std::string, double> &dict);
+    TunableValues tunableTable_[PLAYER_NUMS][MAP_SIZES][HALITE_AS] = {};
+};
 
-    double lookUpTunable(std::string name);
-};
\ No newline at end of file
+/// The tunables of one game, picked out of a Tunables for its player count,
+/// map size and halite abundance.
+class GameTunables {
+public:
+    GameTunables(const Tunables& tunables, int playerNum, int mapSize, int haliteAbundance) :
+        values_(tunables.lookUpValues(playerNum, mapSize, haliteAbundance)) {}
+
+    double lookUpTunable(Tunable tunable) const {
+        return values_[static_cast<int>(tunable)];
+    }
+
+private:
+    Tunables::TunableValues values_;
+};
@@ -0,0 +1,31 @@
+#include "turn_arena.hpp"
+
+using namespace std;
+
+TurnArena::TurnArena(size_t initialBytes) : block_(new byte[initialBytes]), blockBytes_(initialBytes) {
+    buffer_.emplace(block_.get(), blockBytes_, &overflow_);
+}
+
+void TurnArena::reset() {
+    // the buffers handed out by the overflow go back to the heap here
+    buffer_.reset();
+    if (overflow_.bytes > 0) {
+        blockBytes_ += 2 * overflow_.bytes;
+        block_.reset(new byte[blockBytes_]);
+        overflow_.bytes = 0;
+    }
+    buffer_.emplace(block_.get(), blockBytes_, &overflow_);
+}
+
+void* TurnArena::Overflow::do_allocate(size_t bytes, size_t alignment) {
+    this->bytes += bytes;
+    return pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void TurnArena::Overflow::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
+
+bool TurnArena::Overflow::do_is_equal(const pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+using namespace std;
+
+/// Memory for what the bot builds and drops within one turn: explore windows,
+/// candidate lists, direction lists and the like. Allocating is a pointer bump
+/// into one block kept for the whole game, and reset() frees the whole turn at
+/// once. A turn that outgrows the block takes the rest from the heap, and the
+/// block grows to fit before the next turn. The block is left uninitialized,
+/// so a generous size only costs the pages the turns actually reach.
+class TurnArena {
+public:
+    explicit TurnArena(size_t initialBytes = 64 * 1024);
+    TurnArena(const TurnArena&) = delete;
+    TurnArena& operator=(const TurnArena&) = delete;
+
+    /// Free everything allocated since the last reset. Nothing allocated from
+    /// resource() may be used afterwards.
+    void reset();
+
+    pmr::memory_resource* resource() { return &*buffer_; }
+
+    /// Bytes of the block.
+    size_t capacity() const { return blockBytes_; }
+
+private:
+    /// Passes the buffer's overflow on to the heap, noting how much it was.
+    class Overflow : public pmr::memory_resource {
+    public:
+        size_t bytes = 0;
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const pmr::memory_resource& other) const noexcept override;
+    };
+
+    unique_ptr<byte[]> block_;
+    size_t blockBytes_;
+    Overflow overflow_;
+    optional<pmr::monotonic_buffer_resource> buffer_;
+};
@@ -0,0 +1,62 @@
+#include "turn_budget.hpp"
+#include "hlt/log.hpp"
+
+#include <string>
+
+using namespace std;
+using namespace hlt;
+
+TurnBudget::TurnBudget(chrono::milliseconds target) :
+    start_(chrono::steady_clock::now()), deadline_(start_ + target), loggedLevel_(Level::FULL), unlimited_(false) {}
+
+TurnBudget TurnBudget::unlimited() {
+    // a day stands in for forever in remaining(), which callers add to the clock
+    TurnBudget budget(chrono::hours(24));
+    budget.unlimited_ = true;
+    return budget;
+}
+
+chrono::microseconds TurnBudget::elapsed() const {
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start_);
+}
+
+chrono::microseconds TurnBudget::remaining() const {
+    auto now = chrono::steady_clock::now();
+    if (now >= deadline_) {
+        return chrono::microseconds(0);
+    }
+    return chrono::duration_cast<chrono::microseconds>(deadline_ - now);
+}
+
+TurnBudget::Level TurnBudget::level() const {
+    if (unlimited_) {
+        return Level::FULL;
+    }
+    double used = double(elapsed().count()) / double((deadline_ - start_) / chrono::microseconds(1));
+    if (used < 0.5) {
+        return Level::FULL;
+    }
+    else if (used < 0.7) {
+        return Level::REDUCED_LOOKAHEAD;
+    }
+    else if (used < 0.85) {
+        return Level::NO_WIGGLE;
+    }
+    return Level::MINIMAL;
+}
+
+TurnBudget::Level TurnBudget::checkpoint(const char* name) {
+    Level current = level();
+    if (current > loggedLevel_) {
+        LOG_WARNING("Turn budget: degraded to level " + to_string(int(current)) + " at " + name +
+                    " after " + to_string(elapsed().count() / 1000) + "ms");
+        loggedLevel_ = current;
+    }
+    return current;
+}
+
+void TurnBudget::logTurn(int turnNumber) const {
+    if (loggedLevel_ != Level::FULL) {
+        LOG_WARNING("Turn " + to_string(turnNumber) + " took " + to_string(elapsed().count() / 1000) + "ms");
+    }
+}
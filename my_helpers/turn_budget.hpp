@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+
+using namespace std;
+
+/// Wall-clock budget of one turn.
+/// It starts when the frame has been read, and the expensive parts of the turn
+/// ask it how much work they can still afford. As the turn runs late the
+/// level steps down a degrade ladder instead of letting the engine time us out.
+class TurnBudget {
+public:
+    /// The degrade ladder, from doing everything to doing as little as possible.
+    enum class Level {
+        FULL,               // plan normally
+        REDUCED_LOOKAHEAD,  // stop growing explore windows early
+        NO_WIGGLE,          // also skip the extra wiggle directions
+        MINIMAL             // reuse last turn's targets, skip optional work
+    };
+
+    /// The engine allows 2 seconds per turn; aim well below that because we
+    /// share the host with the other bots and the engine.
+    static const int TARGET_MS = 1400;
+
+    explicit TurnBudget(chrono::milliseconds target = chrono::milliseconds(TARGET_MS));
+
+    /// A budget that never runs out and never degrades, so that what the turn
+    /// decides does not depend on how fast the host is (simulated games).
+    static TurnBudget unlimited();
+    bool isUnlimited() const { return unlimited_; }
+
+    chrono::microseconds elapsed() const;
+
+    /// Time left until the target, zero once it has passed.
+    chrono::microseconds remaining() const;
+
+    bool expired() const { return remaining().count() == 0; }
+
+    Level level() const;
+
+    /// Level at a named point of the turn; logs the first time the turn degrades.
+    Level checkpoint(const char* name);
+
+    /// Log how long the turn took, if it took long enough to be worth knowing.
+    void logTurn(int turnNumber) const;
+
+private:
+    chrono::steady_clock::time_point start_;
+    chrono::steady_clock::time_point deadline_;
+    Level loggedLevel_;
+    bool unlimited_;
+};
@@ -0,0 +1,151 @@
+#include "work_stealing_pool.hpp"
+
+#include <algorithm>
+
+using namespace std;
+
+// which pool the current thread works for, and its queue there
+static thread_local WorkStealingPool* currentPool = nullptr;
+static thread_local unsigned int currentWorker = 0;
+
+void WorkStealingPool::Queue::pushBack(function<void()> job) {
+    if (count == jobs.size()) {
+        vector<function<void()>> grown(max<size_t>(8, 2 * jobs.size()));
+        for (size_t i = 0; i < count; i++) {
+            grown[i] = move(jobs[(head + i) % jobs.size()]);
+        }
+        jobs.swap(grown);
+        head = 0;
+    }
+    jobs[(head + count) % jobs.size()] = move(job);
+    count++;
+}
+
+function<void()> WorkStealingPool::Queue::popBack() {
+    count--;
+    return move(jobs[(head + count) % jobs.size()]);
+}
+
+function<void()> WorkStealingPool::Queue::popFront() {
+    function<void()> job = move(jobs[head]);
+    head = (head + 1) % jobs.size();
+    count--;
+    return job;
+}
+
+WorkStealingPool::WorkStealingPool(unsigned int threads) :
+    queued_(0), pending_(0), nextQueue_(0), stopping_(false) {
+    if (threads == 0) {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    for (unsigned int i = 0; i < threads; i++) {
+        queues_.push_back(make_unique<Queue>());
+    }
+    for (unsigned int i = 0; i < threads; i++) {
+        workers_.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        lock_guard<mutex> lock(stateLock_);
+        stopping_ = true;
+    }
+    jobAvailable_.notify_all();
+    for (thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+void WorkStealingPool::submit(function<void()> job) {
+    unsigned int target = currentPool == this ? currentWorker : nextQueue_++ % size();
+    pending_++;
+    {
+        // taking the lock makes sure a worker about to sleep sees the new job
+        lock_guard<mutex> lock(stateLock_);
+        queued_++;
+    }
+    {
+        lock_guard<mutex> lock(queues_[target]->lock);
+        queues_[target]->pushBack(move(job));
+    }
+    jobAvailable_.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    unique_lock<mutex> lock(stateLock_);
+    allDone_.wait(lock, [this] { return pending_ == 0; });
+    if (firstError_) {
+        exception_ptr error = firstError_;
+        firstError_ = nullptr;
+        rethrow_exception(error);
+    }
+}
+
+void WorkStealingPool::runOnEveryThread(const function<void()>& job) {
+    // each copy holds its worker until all have started one, so no worker runs two
+    mutex startedLock;
+    condition_variable allStarted;
+    unsigned int started = 0;
+    for (unsigned int i = 0; i < size(); i++) {
+        submit([&] {
+            job();
+            unique_lock<mutex> lock(startedLock);
+            started++;
+            allStarted.notify_all();
+            allStarted.wait(lock, [&] { return started == size(); });
+        });
+    }
+    wait();
+}
+
+bool WorkStealingPool::takeJob(unsigned int self, function<void()>& job) {
+    {
+        Queue& own = *queues_[self];
+        lock_guard<mutex> lock(own.lock);
+        if (own.count > 0) {
+            job = own.popBack();
+            return true;
+        }
+    }
+    for (unsigned int offset = 1; offset < size(); offset++) {
+        Queue& victim = *queues_[(self + offset) % size()];
+        lock_guard<mutex> lock(victim.lock);
+        if (victim.count > 0) {
+            job = victim.popFront();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(unsigned int self) {
+    currentPool = this;
+    currentWorker = self;
+    function<void()> job;
+    for (;;) {
+        if (takeJob(self, job)) {
+            queued_--;
+            try {
+                job();
+            }
+            catch (...) {
+                lock_guard<mutex> lock(stateLock_);
+                if (!firstError_) {
+                    firstError_ = current_exception();
+                }
+            }
+            job = nullptr;
+            if (--pending_ == 0) {
+                lock_guard<mutex> lock(stateLock_);
+                allDone_.notify_all();
+            }
+            continue;
+        }
+        unique_lock<mutex> lock(stateLock_);
+        jobAvailable_.wait(lock, [this] { return stopping_ || queued_ > 0; });
+        if (stopping_ && queued_ == 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/// A fixed set of worker threads, each with its own job queue.
+/// A worker runs the newest job of its own queue first and, when that is
+/// empty, steals the oldest job of another worker, so uneven jobs (a 64x64
+/// four player game next to a 32x32 two player one) still keep every core busy.
+class WorkStealingPool {
+public:
+    /// 0 threads means one per hardware thread.
+    explicit WorkStealingPool(unsigned int threads = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /// Queue a job. Jobs submitted from a worker go to that worker's own queue.
+    void submit(function<void()> job);
+
+    /// Block until every submitted job has finished. Rethrows the first
+    /// exception a job threw, if any.
+    void wait();
+
+    /// Run job once on each of the pool's threads, such as to set up their
+    /// thread_local state, and wait for all of them. Not from a worker.
+    void runOnEveryThread(const function<void()>& job);
+
+    unsigned int size() const { return unsigned(queues_.size()); }
+
+private:
+    /// A ring of jobs, [head, head + count) modulo the capacity. It doubles
+    /// when full and never shrinks, so a pool running about as many jobs turn
+    /// after turn stops allocating, unlike a deque recycling its blocks.
+    struct Queue {
+        mutex lock;
+        vector<function<void()>> jobs;
+        size_t head = 0;
+        size_t count = 0;
+
+        void pushBack(function<void()> job);
+        function<void()> popBack();
+        function<void()> popFront();
+    };
+
+    bool takeJob(unsigned int self, function<void()>& job);
+    void workerLoop(unsigned int self);
+
+    vector<unique_ptr<Queue>> queues_;
+    vector<thread> workers_;
+
+    atomic<size_t> queued_;  // jobs waiting in any queue
+    atomic<size_t> pending_; // jobs submitted but not finished
+    atomic<unsigned int> nextQueue_;
+
+    mutex stateLock_;
+    condition_variable jobAvailable_;
+    condition_variable allDone_;
+    bool stopping_;
+    exception_ptr firstError_;
+};
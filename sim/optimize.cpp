@@ -0,0 +1,94 @@
+#include "spsa_optimizer.hpp"
+#include "hlt/log.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace hlt;
+
+static void usage() {
+    cerr << "usage: optimize [--iterations n] [--games n] [--verify n] [--threads n] [--seed n] [--turns n]"
+         << " [--a x] [--c x] [--buckets 2-32-0,...] [--dry-run] [folder]" << endl
+         << "Tunes the csv files in folder/csv (default .) and rewrites the ones that verifiably got better." << endl;
+    exit(1);
+}
+
+/// Tunes the csv files with SPSA against local games and writes back the
+/// buckets whose tuned values beat the starting ones.
+int main(int argc, char* argv[]) {
+    SpsaConfig config;
+    bool dryRun = false;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--dry-run") {
+            dryRun = true;
+        } else if (arg.size() > 2 && arg.compare(0, 2, "--") == 0) {
+            if (i + 1 >= argc) {
+                usage();
+            }
+            string value = argv[++i];
+            if (arg == "--iterations") config.iterations = stoi(value);
+            else if (arg == "--games") config.gamesPerIteration = stoi(value);
+            else if (arg == "--verify") config.verifyGames = stoi(value);
+            else if (arg == "--threads") config.threads = unsigned(stoul(value));
+            else if (arg == "--seed") config.seed = unsigned(stoul(value));
+            else if (arg == "--turns") config.maxTurns = stoi(value);
+            else if (arg == "--a") config.a = stod(value);
+            else if (arg == "--c") config.c = stod(value);
+            else if (arg == "--buckets") {
+                config.buckets.clear();
+                size_t start = 0;
+                while (start <= value.size()) {
+                    size_t end = min(value.find(',', start), value.size());
+                    Bucket bucket;
+                    if (!Bucket::parse(value.substr(start, end - start), bucket)) {
+                        cerr << "unknown bucket " << value.substr(start, end - start) << endl;
+                        return 1;
+                    }
+                    config.buckets.push_back(bucket);
+                    start = end + 1;
+                }
+            }
+            else usage();
+        } else {
+            config.tunablesFolder = arg;
+        }
+    }
+
+    // the bots would otherwise keep every message of every game in memory
+    log::set_level(log::Level::Error);
+
+    auto start = chrono::steady_clock::now();
+    SpsaOptimizer optimizer(config);
+    vector<SpsaBucketResult> results = optimizer.run([&](int iteration, const vector<double>& plusWinRates) {
+        double mean = 0;
+        for (double rate : plusWinRates) {
+            mean += rate / plusWinRates.size();
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        printf("iteration %d/%d: plus side won %.1f%% (%.0fs)\n", iteration + 1, config.iterations, 100 * mean, seconds);
+        fflush(stdout);
+    });
+
+    for (const SpsaBucketResult& result : results) {
+        printf("%s: tuned won %.1f%% (at least %.1f%%) of %d against the start\n", result.bucket.name().c_str(),
+               100 * result.verification.winRate(), 100 * result.verification.winRateLowerBound(),
+               result.verification.games);
+        for (size_t i = 0; i < result.tuned.size(); i++) {
+            const Tunables::CsvRow& row = result.tuned[i];
+            printf("  %-14s %10.4g -> %10.4g  [%.4g, %.4g]\n", row.name.c_str(), result.start[i].value, row.value,
+                   row.spreadLow, row.spreadHigh);
+        }
+    }
+    if (!dryRun && config.verifyGames == 0) {
+        cout << "nothing written: the results were not verified (--verify 0)" << endl;
+    }
+    else if (!dryRun) {
+        int written = SpsaOptimizer::writeImproved(config.tunablesFolder, results);
+        cout << "wrote " << written << " of " << results.size() << " csv files" << endl;
+    }
+    return 0;
+}
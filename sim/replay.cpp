@@ -0,0 +1,237 @@
+#include "hlt/game.hpp"
+#include "hlt/input.hpp"
+#include "my_helpers/alloc_tracker.hpp"
+#include "my_helpers/bot.hpp"
+#include "my_helpers/profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace hlt;
+
+/// Plays a recorded game through the bot again, turn by turn and at full speed,
+/// without an engine process.
+///
+/// Usage: replay [--timed] [--log <bot log>] <transcript> [rng seed] [recorded output]
+/// The transcript is what the engine wrote to the bot's stdin, captured with
+/// 'tee input.txt | ./MyBot <seed> > output.txt'. The seed defaults to 0; use
+/// the one the bot logged ("Bot rng seed is ...") to reproduce its game. With
+/// the recorded output, every turn's commands are compared with what the bot
+/// sent back then and the exit code is 1 if any differ, so a folder of
+/// recordings works as a regression suite as well as a benchmark.
+/// Turns plan fully however long they take, so the commands only depend on
+/// the transcript and the seed. --timed gives them the engine's time limit
+/// instead, as in a real game, for timing; its commands can differ from the
+/// recording wherever either run degraded. --log reads the recorded run's
+/// bot log and flags the turns it degraded on: the replay cannot reproduce
+/// those, so they are reported but do not fail it.
+/// The heap allocations of every turn are counted too, parsing the frame and
+/// logging at the bot's own level included: a turn after the first making
+/// more than Bot::TURN_ALLOCATION_BUDGET makes the exit code 1 as well. The
+/// log goes to bot-<id>.log, as the bot's does.
+/// Run it from the folder holding the csv folder, like the bot itself. The bot
+/// plans on every hardware thread, as MyBot does.
+
+bool readFile(const string& path, string& contents) {
+    ifstream file(path, ios::binary);
+    if (!file) {
+        cerr << "cannot open " << path << endl;
+        return false;
+    }
+    contents.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    return true;
+}
+
+/// The commands of each turn as MyBot prints them, the bot's name line dropped.
+vector<string> readRecordedTurns(const string& output) {
+    vector<string> turns;
+    istringstream in(output);
+    string line;
+    getline(in, line); // the bot's name
+    while (getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        turns.push_back(line);
+    }
+    return turns;
+}
+
+/// One turn's commands, exactly as Game::end_turn would print them.
+string formatCommands(const vector<Command>& commands) {
+    ostringstream out;
+    for (const Command& command : commands) {
+        out << command << ' ';
+    }
+    return out.str();
+}
+
+/// The turns a bot log says were degraded: TurnBudget::logTurn logs "Turn <n> took <t>ms" for them.
+set<int> readDegradedTurns(const string& log) {
+    set<int> turns;
+    istringstream in(log);
+    string line;
+    while (getline(in, line)) {
+        int turn;
+        char rest[8];
+        if (sscanf(line.c_str(), "Turn %d took %7s", &turn, rest) == 2) {
+            turns.insert(turn);
+        }
+    }
+    return turns;
+}
+
+int main(int argc, char* argv[]) {
+    bool timed = false;
+    string logPath;
+    vector<string> arguments;
+    for (int i = 1; i < argc; i++) {
+        const string arg = argv[i];
+        if (arg == "--timed") {
+            timed = true;
+        }
+        else if (arg == "--log" && i + 1 < argc) {
+            logPath = argv[++i];
+        }
+        else {
+            arguments.push_back(arg);
+        }
+    }
+    if (arguments.empty() || arguments.size() > 3) {
+        cerr << "usage: replay [--timed] [--log <bot log>] <transcript> [rng seed] [recorded output]" << endl;
+        return 1;
+    }
+    string transcript;
+    if (!readFile(arguments[0], transcript)) {
+        return 1;
+    }
+    unsigned int rngSeed = arguments.size() > 1 ? static_cast<unsigned int>(stoul(arguments[1])) : 0;
+    bool compare = arguments.size() > 2;
+    vector<string> recorded;
+    if (compare) {
+        string output;
+        if (!readFile(arguments[2], output)) {
+            return 1;
+        }
+        recorded = readRecordedTurns(output);
+    }
+    set<int> degraded;
+    if (!logPath.empty()) {
+        string log;
+        if (!readFile(logPath, log)) {
+            return 1;
+        }
+        degraded = readDegradedTurns(log);
+    }
+
+    using Clock = chrono::steady_clock;
+    Game game(Input::from_string(std::move(transcript)));
+    Bot bot(game, rngSeed, ".");
+    bot.setPlanningThreads(0);
+    bot.setTimeLimited(timed);
+    PROFILE_OPEN(game.my_id);
+
+    struct TurnTime {
+        int turn;
+        chrono::microseconds time;
+    };
+    vector<TurnTime> times;
+    times.reserve(game.constants.MAX_TURNS + 1);
+    int mismatches = 0;
+    int degradedMismatches = 0;
+    const int MAX_REPORTED = 5;
+    // the first turn sets up the buffers the others reuse
+    long long allocations = 0;
+    int turnsOverBudget = 0;
+    for (size_t i = 0; !game.input.at_end(); i++) {
+        const long long allocationsBefore = AllocTracker::allocations();
+        auto start = Clock::now();
+        game.update_frame();
+        const vector<Command>& commands = bot.playTurn(game);
+        const long long turnAllocations = AllocTracker::allocations() - allocationsBefore;
+        times.push_back({ game.turn_number, chrono::duration_cast<chrono::microseconds>(Clock::now() - start) });
+        PROFILE_END_TURN(game.turn_number);
+        if (i > 0) {
+            allocations += turnAllocations;
+            if (turnAllocations > Bot::TURN_ALLOCATION_BUDGET) {
+                if (turnsOverBudget < MAX_REPORTED) {
+                    cout << "turn " << game.turn_number << " made " << turnAllocations << " heap allocations" << endl;
+                }
+                turnsOverBudget++;
+            }
+        }
+
+        if (!compare) {
+            continue;
+        }
+        const string sent = formatCommands(commands);
+        const string expected = i < recorded.size() ? recorded[i] : "(none)";
+        if (sent != expected) {
+            const bool wasDegraded = degraded.count(game.turn_number) > 0;
+            if (mismatches + degradedMismatches < MAX_REPORTED) {
+                cout << "turn " << game.turn_number << " differs"
+                     << (wasDegraded ? " (the recorded run degraded on it)" : "") << endl
+                     << "  recorded: " << expected << endl
+                     << "  replayed: " << sent << endl;
+            }
+            (wasDegraded ? degradedMismatches : mismatches)++;
+        }
+    }
+    if (times.empty()) {
+        cerr << arguments[0] << " has no turns" << endl;
+        return 1;
+    }
+
+    chrono::microseconds total(0);
+    for (const TurnTime& t : times) {
+        total += t.time;
+    }
+    sort(times.begin(), times.end(), [](const TurnTime& a, const TurnTime& b) { return a.time > b.time; });
+    cout << times.size() << " turns in " << total.count() / 1000.0 << "ms, "
+         << total.count() / times.size() << "us/turn on average" << endl;
+    cout << "slowest turns:";
+    for (size_t i = 0; i < min<size_t>(5, times.size()); i++) {
+        cout << ' ' << times[i].turn << " (" << times[i].time.count() << "us)";
+    }
+    cout << endl;
+    cout << allocations << " heap allocations after the first turn" << endl;
+    if (turnsOverBudget > 0) {
+        cout << turnsOverBudget << " turns over the budget of " << Bot::TURN_ALLOCATION_BUDGET << " allocations" << endl;
+    }
+
+    if (!degraded.empty()) {
+        cout << "the recorded run degraded on " << degraded.size() << " turns:";
+        for (int turn : degraded) {
+            cout << ' ' << turn;
+        }
+        cout << endl;
+    }
+
+    if (compare) {
+        if (recorded.size() != times.size()) {
+            cout << "recorded output has " << recorded.size() << " turns, the transcript " << times.size() << endl;
+            mismatches++;
+        }
+        if (degradedMismatches > 0) {
+            cout << degradedMismatches << " differences on turns the recorded run degraded on" << endl;
+        }
+        if (mismatches == 0) {
+            cout << "commands match the recording" << (degradedMismatches > 0 ? " elsewhere" : "") << endl;
+        }
+        else {
+            cout << mismatches << " differences from the recording" << endl;
+        }
+        if (timed && mismatches > 0) {
+            cout << "the turns were timed (--timed), so some differences may come from degrading" << endl;
+        }
+    }
+    return mismatches == 0 && turnsOverBudget == 0 ? 0 : 1;
+}
@@ -0,0 +1,54 @@
+#include "simulator.hpp"
+#include "hlt/log.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace hlt;
+
+/// Plays games between copies of the bot in-process and prints the results.
+///
+/// Usage: simulate [games] [map size] [players] [first seed] [turns] [trace folder]
+/// Defaults to 10 two-player games on 32x32 maps with the full number of turns.
+/// With a trace folder, every bot records its games there (read them with trace_dump).
+/// Run it from the folder holding the csv folder, like the bot itself.
+int main(int argc, char* argv[]) {
+    int games = argc > 1 ? stoi(argv[1]) : 10;
+    SimulationConfig config;
+    config.mapSize = argc > 2 ? stoi(argv[2]) : 32;
+    config.nPlayers = argc > 3 ? stoi(argv[3]) : 2;
+    unsigned int firstSeed = argc > 4 ? static_cast<unsigned int>(stoul(argv[4])) : 1;
+    config.maxTurns = argc > 5 ? stoi(argv[5]) : 0;
+    config.traceFolder = argc > 6 ? argv[6] : "";
+
+    // the bots would otherwise keep every message of every game in memory
+    log::set_level(log::Level::Error);
+
+    vector<long long> totalHalite(config.nPlayers, 0);
+    vector<int> wins(config.nPlayers, 0);
+    auto start = chrono::steady_clock::now();
+    for (int game = 0; game < games; game++) {
+        config.seed = firstSeed + game;
+        SimulationResult result = Simulator(config).run();
+        cout << "seed " << config.seed;
+        for (int id = 0; id < config.nPlayers; id++) {
+            cout << "  p" << id << ' ' << result.halite[id]
+                 << " (ships " << result.shipsBuilt[id] << ", lost " << result.shipsLost[id]
+                 << ", dropoffs " << result.dropoffsBuilt[id] << ')';
+            totalHalite[id] += result.halite[id];
+            if (result.rank[id] == 1) {
+                wins[id]++;
+            }
+        }
+        cout << endl;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    for (int id = 0; id < config.nPlayers; id++) {
+        cout << "p" << id << ": mean halite " << totalHalite[id] / max(games, 1) << ", wins " << wins[id] << endl;
+    }
+    cout << games << " games in " << seconds << "s (" << games / seconds * 60 << " games/minute)" << endl;
+    return 0;
+}
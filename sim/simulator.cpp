@@ -0,0 +1,412 @@
+#include "simulator.hpp"
+#include "hlt/constants.hpp"
+#include "my_helpers/bot.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <random>
+
+using namespace std;
+using namespace hlt;
+
+Simulator::Simulator(const SimulationConfig& config) :
+    config_(config), constants_(defaultConstants(config.mapSize)), width_(config.mapSize), height_(config.mapSize) {
+    assert(config.nPlayers == 2 || config.nPlayers == 4);
+    assert(config.mapSize >= 32 && config.mapSize <= 64 && config.mapSize % 8 == 0);
+}
+
+Constants Simulator::defaultConstants(int mapSize) {
+    Constants constants;
+    constants.MAX_HALITE = 1000;
+    constants.SHIP_COST = 1000;
+    constants.DROPOFF_COST = 4000;
+    constants.MAX_TURNS = 300 + 25 * mapSize / 8;
+    constants.EXTRACT_RATIO = 4;
+    constants.MOVE_COST_RATIO = 10;
+    constants.INSPIRATION_ENABLED = true;
+    constants.INSPIRATION_RADIUS = 4;
+    constants.INSPIRATION_SHIP_COUNT = 2;
+    constants.INSPIRED_EXTRACT_RATIO = 4;
+    constants.INSPIRED_BONUS_MULTIPLIER = 2.0;
+    constants.INSPIRED_MOVE_COST_RATIO = 10;
+    return constants;
+}
+
+PlayerFactory Simulator::botPlayer(unsigned int rngSeed, const string& tunablesFolder) {
+    return botPlayer(rngSeed, Tunables::load(tunablesFolder));
+}
+
+PlayerFactory Simulator::botPlayer(unsigned int rngSeed, shared_ptr<const Tunables> tunables,
+                                   const string& tracePath) {
+    return [rngSeed, tunables, tracePath](Game& game) -> TurnFunction {
+        shared_ptr<Bot> bot = make_shared<Bot>(game, rngSeed, tunables);
+        // games running side by side must not decide differently when the host is busy
+        bot->setTimeLimited(false);
+        if (!tracePath.empty()) {
+            bot->openTrace(tracePath, game);
+        }
+        return [bot](Game& game) -> vector<Command> { return bot->playTurn(game); };
+    };
+}
+
+int Simulator::index(const Position& position) const {
+    return wrap_coordinate(position.y, height_) * width_ + wrap_coordinate(position.x, width_);
+}
+
+/// Symmetric map: value noise over one tile (half the map for two players,
+/// a quarter for four), mirrored onto the other players' tiles.
+void Simulator::generateMap() {
+    mt19937 rng(config_.seed);
+    uniform_real_distribution<double> unit(0.0, 1.0);
+
+    const int tileWidth = width_ / 2;
+    const int tileHeight = config_.nPlayers == 4 ? height_ / 2 : height_;
+
+    vector<double> noise((size_t)tileWidth * tileHeight, 0.0);
+    double amplitude = 1.0;
+    for (int cellSize = tileWidth / 2; cellSize >= 1; cellSize /= 2) {
+        const int gridWidth = tileWidth / cellSize + 2;
+        const int gridHeight = tileHeight / cellSize + 2;
+        vector<double> grid((size_t)gridWidth * gridHeight);
+        for (double& value : grid) {
+            value = unit(rng);
+        }
+        for (int y = 0; y < tileHeight; y++) {
+            const int gy = y / cellSize;
+            const double fy = double(y % cellSize) / cellSize;
+            for (int x = 0; x < tileWidth; x++) {
+                const int gx = x / cellSize;
+                const double fx = double(x % cellSize) / cellSize;
+                const double top = grid[gy * gridWidth + gx] * (1 - fx) + grid[gy * gridWidth + gx + 1] * fx;
+                const double bottom = grid[(gy + 1) * gridWidth + gx] * (1 - fx) + grid[(gy + 1) * gridWidth + gx + 1] * fx;
+                noise[y * tileWidth + x] += amplitude * (top * (1 - fy) + bottom * fy);
+            }
+        }
+        amplitude *= 0.7;
+    }
+
+    const double lowest = *min_element(noise.begin(), noise.end());
+    const double highest = *max_element(noise.begin(), noise.end());
+    // a random exponent spreads games over sparse and rich maps
+    const double exponent = 1.5 + 2.0 * unit(rng);
+    const double maxHalite = 900 + 100 * unit(rng);
+
+    vector<double> shaped(noise.size());
+    double mean = 0;
+    for (size_t i = 0; i < noise.size(); i++) {
+        shaped[i] = pow((noise[i] - lowest) / max(highest - lowest, 1e-9), exponent) * maxHalite;
+        mean += shaped[i] / noise.size();
+    }
+    // Bot::findHaliteAbundanceKey splits maps at an average of 116 and 194
+    double scale = 1.0;
+    if (config_.haliteAbundance >= 0) {
+        const double lowestMean[] = { 60, 125, 205 };
+        const double highestMean[] = { 110, 185, 280 };
+        const int bucket = config_.haliteAbundance;
+        const double target = lowestMean[bucket] + (highestMean[bucket] - lowestMean[bucket]) * unit(rng);
+        scale = target / max(mean, 1.0);
+    }
+
+    halite_.assign((size_t)width_ * height_, 0);
+    for (int y = 0; y < tileHeight; y++) {
+        for (int x = 0; x < tileWidth; x++) {
+            const Halite value = Halite(min(round(shaped[y * tileWidth + x] * scale), double(constants_.MAX_HALITE)));
+            const int mirrorX = width_ - 1 - x;
+            const int mirrorY = height_ - 1 - y;
+            halite_[y * width_ + x] = value;
+            halite_[y * width_ + mirrorX] = value;
+            if (config_.nPlayers == 4) {
+                halite_[mirrorY * width_ + x] = value;
+                halite_[mirrorY * width_ + mirrorX] = value;
+            }
+        }
+    }
+}
+
+void Simulator::placeShipyards() {
+    const int nearX = width_ / 4;
+    const int farX = width_ - 1 - width_ / 4;
+    vector<Position> shipyards;
+    if (config_.nPlayers == 2) {
+        shipyards = { Position(nearX, height_ / 2), Position(farX, height_ / 2) };
+    }
+    else {
+        const int nearY = height_ / 4;
+        const int farY = height_ - 1 - height_ / 4;
+        shipyards = { Position(nearX, nearY), Position(farX, nearY), Position(nearX, farY), Position(farX, farY) };
+    }
+
+    structureOwner_.assign((size_t)width_ * height_, -1);
+    players_.clear();
+    for (PlayerId id = 0; id < config_.nPlayers; id++) {
+        players_.push_back({ shipyards[id], 5000 });
+        halite_[index(shipyards[id])] = 0;
+        structureOwner_[index(shipyards[id])] = id;
+    }
+}
+
+void Simulator::publishFrame(int turnNumber) {
+    for (unique_ptr<Game>& game : games_) {
+        game->turn_number = turnNumber;
+        for (PlayerId id = 0; id < config_.nPlayers; id++) {
+            Player& player = *game->players[id];
+            player._begin_update(game->ship_pool, players_[id].halite);
+            for (const SimShip& ship : ships_) {
+                if (ship.alive && ship.owner == id) {
+                    player._update_ship(game->ship_pool, Ship(id, ship.id, ship.position.x, ship.position.y, ship.halite));
+                }
+            }
+            for (const SimDropoff& dropoff : dropoffs_) {
+                if (dropoff.owner == id) {
+                    player._update_dropoff(game->dropoff_pool, Dropoff(id, dropoff.id, dropoff.position.x, dropoff.position.y));
+                }
+            }
+            player._end_update(game->ship_pool);
+        }
+        game->game_map->_update(halite_);
+        game->_finish_frame();
+    }
+}
+
+/// A ship is inspired by at least INSPIRATION_SHIP_COUNT opponent ships
+/// within INSPIRATION_RADIUS, counted on the positions every bot was shown.
+void Simulator::computeInspiration() {
+    vector<PlayerId> owner((size_t)width_ * height_, -1);
+    for (const SimShip& ship : ships_) {
+        if (ship.alive) {
+            owner[index(ship.position)] = ship.owner;
+        }
+    }
+    const int radius = constants_.INSPIRATION_RADIUS;
+    for (SimShip& ship : ships_) {
+        if (!ship.alive) {
+            continue;
+        }
+        ship.inspired = false;
+        if (!constants_.INSPIRATION_ENABLED) {
+            continue;
+        }
+        int opponents = 0;
+        for (int dy = -radius; dy <= radius && !ship.inspired; dy++) {
+            const int reach = radius - abs(dy);
+            for (int dx = -reach; dx <= reach; dx++) {
+                const PlayerId cellOwner = owner[index(Position(ship.position.x + dx, ship.position.y + dy))];
+                if (cellOwner != -1 && cellOwner != ship.owner && ++opponents >= constants_.INSPIRATION_SHIP_COUNT) {
+                    ship.inspired = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/// Invalid commands (someone else's ship, a second command for a ship, a move
+/// the ship cannot pay for) are ignored and the ship stays still, as with a
+/// non-strict engine.
+void Simulator::applyCommands(PlayerId player, const vector<Command>& commands) {
+    bool spawn = false;
+    for (const Command& command : commands) {
+        if (command.empty()) {
+            continue;
+        }
+        if (command[0] == 'g') {
+            spawn = true;
+            continue;
+        }
+        if (command.size() < 3 || (command[0] != 'c' && command[0] != 'm')) {
+            continue;
+        }
+        size_t idEnd = 0;
+        const EntityId id = stoi(command.substr(2), &idEnd);
+        if (id < 0 || static_cast<size_t>(id) >= ships_.size()) {
+            continue;
+        }
+        SimShip& ship = ships_[id];
+        if (!ship.alive || ship.owner != player || ship.commanded) {
+            continue;
+        }
+        ship.commanded = true;
+        const int cell = index(ship.position);
+
+        if (command[0] == 'c') {
+            const int cost = constants_.DROPOFF_COST - ship.halite - halite_[cell];
+            if (structureOwner_[cell] != -1 || players_[player].halite < cost) {
+                continue;
+            }
+            players_[player].halite -= cost;
+            halite_[cell] = 0;
+            ship.alive = false;
+            structureOwner_[cell] = player;
+            dropoffs_.push_back({ EntityId(dropoffs_.size()), player, ship.position });
+            result_.dropoffsBuilt[player]++;
+            continue;
+        }
+
+        const size_t directionAt = 2 + idEnd + 1;
+        if (directionAt >= command.size()) {
+            continue;
+        }
+        const Direction direction = static_cast<Direction>(command[directionAt]);
+        if (direction == Direction::STILL) {
+            continue;
+        }
+        const int ratio = ship.inspired ? constants_.INSPIRED_MOVE_COST_RATIO : constants_.MOVE_COST_RATIO;
+        const Halite cost = halite_[cell] / ratio;
+        if (ship.halite < cost) {
+            continue;
+        }
+        ship.halite -= cost;
+        ship.position = ship.position.directional_offset(direction);
+        ship.position = Position(wrap_coordinate(ship.position.x, width_), wrap_coordinate(ship.position.y, height_));
+        ship.moved = true;
+    }
+
+    if (spawn && players_[player].halite >= constants_.SHIP_COST) {
+        players_[player].halite -= constants_.SHIP_COST;
+        const EntityId id = EntityId(ships_.size());
+        ships_.push_back({ id, player, players_[player].shipyard, 0, true, true, false, true });
+        result_.shipsBuilt[player]++;
+    }
+}
+
+/// Ships ending up on the same cell all sink. Their cargo goes to the owner of
+/// a shipyard or dropoff on that cell, or into the sea otherwise.
+void Simulator::resolveCollisions() {
+    shipsAt_.assign((size_t)width_ * height_, 0);
+    for (const SimShip& ship : ships_) {
+        if (ship.alive) {
+            shipsAt_[index(ship.position)]++;
+        }
+    }
+    for (SimShip& ship : ships_) {
+        if (!ship.alive) {
+            continue;
+        }
+        const int cell = index(ship.position);
+        if (shipsAt_[cell] < 2) {
+            continue;
+        }
+        if (structureOwner_[cell] != -1) {
+            players_[structureOwner_[cell]].halite += ship.halite;
+        }
+        else {
+            halite_[cell] += ship.halite;
+        }
+        ship.alive = false;
+        result_.shipsLost[ship.owner]++;
+    }
+}
+
+/// Ships that stayed still collect a quarter (EXTRACT_RATIO) of the cell,
+/// rounded up, plus the inspiration bonus; ships on their own shipyard or
+/// dropoff deposit their cargo.
+void Simulator::mineAndDeposit() {
+    for (SimShip& ship : ships_) {
+        if (!ship.alive) {
+            continue;
+        }
+        const int cell = index(ship.position);
+        if (!ship.moved && halite_[cell] > 0) {
+            const int ratio = ship.inspired ? constants_.INSPIRED_EXTRACT_RATIO : constants_.EXTRACT_RATIO;
+            Halite extracted = (halite_[cell] + ratio - 1) / ratio;
+            extracted = min(extracted, constants_.MAX_HALITE - ship.halite);
+            Halite gained = extracted;
+            if (ship.inspired) {
+                gained += Halite(extracted * constants_.INSPIRED_BONUS_MULTIPLIER);
+            }
+            gained = min(gained, constants_.MAX_HALITE - ship.halite);
+            halite_[cell] -= extracted;
+            ship.halite += gained;
+            result_.collected[ship.owner] += gained;
+        }
+        if (structureOwner_[cell] == ship.owner) {
+            players_[ship.owner].halite += ship.halite;
+            ship.halite = 0;
+        }
+    }
+}
+
+void Simulator::rankPlayers() {
+    for (PlayerId id = 0; id < config_.nPlayers; id++) {
+        result_.halite[id] = players_[id].halite;
+    }
+    for (PlayerId id = 0; id < config_.nPlayers; id++) {
+        int rank = 1;
+        for (PlayerId other = 0; other < config_.nPlayers; other++) {
+            if (result_.halite[other] > result_.halite[id]) {
+                rank++;
+            }
+        }
+        result_.rank[id] = rank;
+    }
+}
+
+SimulationResult Simulator::run() {
+    vector<PlayerFactory> players;
+    for (int id = 0; id < config_.nPlayers; id++) {
+        string tracePath;
+        if (!config_.traceFolder.empty()) {
+            tracePath = config_.traceFolder + "/trace-" + to_string(config_.seed) + "-" + to_string(id) + ".bin";
+        }
+        players.push_back(botPlayer(config_.seed + id, Tunables::load(config_.tunablesFolder), tracePath));
+    }
+    return run(players);
+}
+
+SimulationResult Simulator::run(const vector<PlayerFactory>& players) {
+    assert(int(players.size()) == config_.nPlayers);
+    constants_ = defaultConstants(config_.mapSize);
+    if (config_.maxTurns > 0) {
+        constants_.MAX_TURNS = config_.maxTurns;
+    }
+
+    const int n = config_.nPlayers;
+    result_ = SimulationResult();
+    result_.halite.assign(n, 0);
+    result_.rank.assign(n, 0);
+    result_.shipsBuilt.assign(n, 0);
+    result_.dropoffsBuilt.assign(n, 0);
+    result_.shipsLost.assign(n, 0);
+    result_.collected.assign(n, 0);
+    ships_.clear();
+    dropoffs_.clear();
+
+    generateMap();
+    placeShipyards();
+
+    games_.clear();
+    vector<TurnFunction> turnFunctions;
+    for (PlayerId seat = 0; seat < n; seat++) {
+        vector<shared_ptr<Player>> gamePlayers;
+        for (PlayerId id = 0; id < n; id++) {
+            gamePlayers.push_back(make_shared<Player>(id, players_[id].shipyard.x, players_[id].shipyard.y));
+        }
+        games_.push_back(make_unique<Game>(constants_, seat, gamePlayers, GameMap::_generate(width_, height_, halite_)));
+        turnFunctions.push_back(players[seat](*games_.back()));
+    }
+
+    for (int turn = 1; turn <= constants_.MAX_TURNS; turn++) {
+        computeInspiration();
+        publishFrame(turn);
+        vector<vector<Command>> commands(n);
+        for (PlayerId seat = 0; seat < n; seat++) {
+            commands[seat] = turnFunctions[seat](*games_[seat]);
+        }
+
+        for (SimShip& ship : ships_) {
+            ship.moved = false;
+            ship.commanded = false;
+        }
+        for (PlayerId seat = 0; seat < n; seat++) {
+            applyCommands(seat, commands[seat]);
+        }
+        resolveCollisions();
+        mineAndDeposit();
+        result_.turns = turn;
+    }
+
+    rankPlayers();
+    games_.clear();
+    return result_;
+}
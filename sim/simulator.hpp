@@ -0,0 +1,120 @@
+#pragma once
+
+#include "hlt/game.hpp"
+#include "hlt/constants.hpp"
+#include "hlt/command.hpp"
+#include "hlt/position.hpp"
+#include "my_helpers/tunables.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace hlt;
+
+/// How to set up a simulated game.
+struct SimulationConfig {
+    int mapSize = 32;         // 32, 40, 48, 56 or 64
+    int nPlayers = 2;         // 2 or 4
+    unsigned int seed = 0;    // map seed; bots get seed + player id
+    int maxTurns = 0;         // 0 plays the usual 300 + 25 * mapSize / 8 turns
+    int haliteAbundance = -1; // 0, 1 or 2 to scale the map into that tunables bucket, -1 leaves it as generated
+    string tunablesFolder = "."; // the folder holding the csv folder
+    string traceFolder;          // if set, run() has each bot write trace-<seed>-<seat>.bin there
+};
+
+/// What happened in a simulated game, indexed by player id.
+struct SimulationResult {
+    int turns = 0;
+    vector<Halite> halite;       // stored halite at the end of the game
+    vector<int> rank;            // 1 for the winner
+    vector<int> shipsBuilt;
+    vector<int> dropoffsBuilt;
+    vector<int> shipsLost;       // ships sunk in collisions
+    vector<long long> collected; // halite mined, before any was lost or spent
+};
+
+/// Plays one seat: given the seat's Game, with the frame filled in, returns
+/// the commands for the turn.
+typedef function<vector<Command>(Game&)> TurnFunction;
+
+/// Creates a seat's player once its Game has been set up (before turn 1).
+typedef function<TurnFunction(Game&)> PlayerFactory;
+
+/// A headless Halite III engine that runs bots in the same process.
+/// Each player sees the game through its own hlt::Game, kept up to date the way
+/// Game::update_frame does from engine input, so bots run unchanged. The rules
+/// follow docs/game-overview.md and use the game's hlt::Constants:
+/// spawning, converting ships into dropoffs, move costs, mining with
+/// EXTRACT_RATIO, inspiration, collisions and depositing.
+class Simulator {
+public:
+    explicit Simulator(const SimulationConfig& config);
+
+    /// Play a whole game; players[i] plays seat i.
+    SimulationResult run(const vector<PlayerFactory>& players);
+
+    /// Play a whole game with our own Bot in every seat.
+    SimulationResult run();
+
+    /// A seat played by our Bot.
+    static PlayerFactory botPlayer(unsigned int rngSeed, const string& tunablesFolder);
+    /// tracePath: if not empty, the bot records the game there (see TraceWriter).
+    static PlayerFactory botPlayer(unsigned int rngSeed, shared_ptr<const Tunables> tunables,
+                                   const string& tracePath = "");
+
+    /// The constants of the standard game for this map size.
+    static Constants defaultConstants(int mapSize);
+
+private:
+    struct SimShip {
+        EntityId id;
+        PlayerId owner;
+        Position position;
+        Halite halite;
+        bool moved;     // moved or was spawned this turn, so does not mine
+        bool commanded; // already given a command this turn
+        bool inspired;
+        bool alive;
+    };
+
+    struct SimDropoff {
+        EntityId id;
+        PlayerId owner;
+        Position position;
+    };
+
+    struct SimPlayer {
+        Position shipyard;
+        Halite halite;
+    };
+
+    void generateMap();
+    void placeShipyards();
+    int index(const Position& position) const;
+
+    /// Fill in every player's Game with the current state.
+    void publishFrame(int turnNumber);
+
+    void computeInspiration();
+    void applyCommands(PlayerId player, const vector<Command>& commands);
+    void resolveCollisions();
+    void mineAndDeposit();
+    void rankPlayers();
+
+    SimulationConfig config_;
+    Constants constants_;
+    int width_;
+    int height_;
+    vector<Halite> halite_;
+    vector<PlayerId> structureOwner_; // -1 for cells without a shipyard or dropoff
+    vector<SimPlayer> players_;
+    vector<SimShip> ships_;          // indexed by ship id
+    vector<SimDropoff> dropoffs_;    // indexed by dropoff id
+    vector<int> shipsAt_;            // ships on each cell, only valid while resolving collisions
+
+    vector<unique_ptr<Game>> games_;
+    SimulationResult result_;
+};
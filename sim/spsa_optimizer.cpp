@@ -0,0 +1,159 @@
+#include "spsa_optimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace std;
+
+SpsaOptimizer::SpsaOptimizer(const SpsaConfig& config) : config_(config) {}
+
+double SpsaOptimizer::clampAndRound(const Tunables::CsvRow& row, double value) {
+    value = min(max(value, row.min), row.max);
+    return row.type == "int" ? round(value) : value;
+}
+
+Tunables::TunableValues SpsaOptimizer::toValues(const Tunables::TunableValues& base, const vector<Tunables::CsvRow>& rows,
+                                                const vector<double>& x) {
+    Tunables::TunableValues values = base;
+    for (size_t i = 0; i < rows.size(); i++) {
+        int index = Tunables::tunableIndex(rows[i].name);
+        if (index >= 0) {
+            values[index] = clampAndRound(rows[i], x[i]);
+        }
+    }
+    return values;
+}
+
+vector<SpsaBucketResult> SpsaOptimizer::run(Progress progress) {
+    const size_t nBuckets = config_.buckets.size();
+    vector<SpsaBucketResult> results(nBuckets);
+    vector<vector<double>> x(nBuckets);        // current point, unrounded
+    vector<vector<double>> sum(nBuckets);      // over the averaged iterations
+    vector<vector<double>> sumSquares(nBuckets);
+    vector<Tunables::TunableValues> base(nBuckets);
+    shared_ptr<const Tunables> startTunables = Tunables::load(config_.tunablesFolder);
+    for (size_t b = 0; b < nBuckets; b++) {
+        const Bucket& bucket = config_.buckets[b];
+        base[b] = startTunables->lookUpValues(bucket.nPlayers, bucket.mapSize, bucket.haliteAbundance);
+        results[b].bucket = bucket;
+        results[b].start = Tunables::readCsvRows(
+            Tunables::csvPath(config_.tunablesFolder, bucket.nPlayers, bucket.mapSize, bucket.haliteAbundance));
+        for (const Tunables::CsvRow& row : results[b].start) {
+            x[b].push_back(row.value);
+        }
+        sum[b].assign(x[b].size(), 0);
+        sumSquares[b].assign(x[b].size(), 0);
+    }
+
+    const double stability = config_.iterations / 10.0;
+    const int firstAveraged = config_.iterations / 2;
+    mt19937 rng(config_.seed);
+    for (int k = 0; k < config_.iterations; k++) {
+        const double ck = config_.c / pow(k + 1, config_.gamma);
+        const double ak = config_.a / pow(k + 1 + stability, config_.alpha);
+
+        Contender plus = { "plus", config_.tunablesFolder, {} };
+        Contender minus = { "minus", config_.tunablesFolder, {} };
+        vector<vector<int>> deltas(nBuckets);
+        for (size_t b = 0; b < nBuckets; b++) {
+            const vector<Tunables::CsvRow>& rows = results[b].start;
+            vector<double> plusX = x[b];
+            vector<double> minusX = x[b];
+            for (size_t i = 0; i < rows.size(); i++) {
+                int delta = (rng() & 1) ? 1 : -1;
+                deltas[b].push_back(delta);
+                plusX[i] += ck * rows[i].mut * delta;
+                minusX[i] -= ck * rows[i].mut * delta;
+            }
+            const string name = config_.buckets[b].name();
+            plus.overrides[name] = toValues(base[b], rows, plusX);
+            minus.overrides[name] = toValues(base[b], rows, minusX);
+        }
+
+        TournamentConfig games;
+        games.buckets = config_.buckets;
+        games.gamesPerBucket = config_.gamesPerIteration;
+        games.threads = config_.threads;
+        games.maxTurns = config_.maxTurns;
+        games.seed = config_.seed + 7919 * (k + 1);
+        Tournament tournament(games, minus, { plus });
+        tournament.run();
+
+        vector<double> plusWinRates(nBuckets);
+        for (size_t b = 0; b < nBuckets; b++) {
+            const vector<Tunables::CsvRow>& rows = results[b].start;
+            plusWinRates[b] = tournament.stats(0, b).winRate();
+            // y(plus) - y(minus), scoring a win as 1 and a loss as -1
+            const double difference = 2 * (2 * plusWinRates[b] - 1);
+            for (size_t i = 0; i < rows.size(); i++) {
+                // the gradient estimate is difference / (2 c_k mut delta), delta is +-1
+                x[b][i] += ak * difference / (2 * ck) * deltas[b][i] * rows[i].mut;
+                x[b][i] = min(max(x[b][i], rows[i].min), rows[i].max);
+                if (k >= firstAveraged) {
+                    sum[b][i] += x[b][i];
+                    sumSquares[b][i] += x[b][i] * x[b][i];
+                }
+            }
+        }
+        if (progress) {
+            progress(k, plusWinRates);
+        }
+    }
+
+    // Averaging the late iterates cancels much of the noise of single steps.
+    // Their spread (mean +- 1.96 sd of the iterates) shows how far they still
+    // wandered; it says nothing about how far the average is from the optimum.
+    const int averaged = config_.iterations - firstAveraged;
+    Contender tuned = { "tuned", config_.tunablesFolder, {} };
+    for (size_t b = 0; b < nBuckets; b++) {
+        results[b].tuned = results[b].start;
+        vector<double> mean = x[b];
+        for (size_t i = 0; i < mean.size(); i++) {
+            Tunables::CsvRow& row = results[b].tuned[i];
+            if (averaged > 0) {
+                mean[i] = sum[b][i] / averaged;
+            }
+            double variance = averaged > 0 ? max(0.0, sumSquares[b][i] / averaged - mean[i] * mean[i]) : 0;
+            row.value = clampAndRound(row, mean[i]);
+            row.hasSpread = true;
+            row.spreadLow = max(row.min, mean[i] - 1.96 * sqrt(variance));
+            row.spreadHigh = min(row.max, mean[i] + 1.96 * sqrt(variance));
+        }
+        tuned.overrides[config_.buckets[b].name()] = toValues(base[b], results[b].tuned, mean);
+    }
+
+    if (config_.verifyGames > 0) {
+        Contender start = { "start", config_.tunablesFolder, {} };
+        TournamentConfig games;
+        games.buckets = config_.buckets;
+        games.gamesPerBucket = config_.verifyGames;
+        games.threads = config_.threads;
+        games.maxTurns = config_.maxTurns;
+        // seeds none of the iterations used
+        games.seed = config_.seed + 7919 * (config_.iterations + 1);
+        Tournament tournament(games, start, { tuned });
+        tournament.run();
+        for (size_t b = 0; b < nBuckets; b++) {
+            results[b].verification = tournament.stats(0, b);
+        }
+    }
+    return results;
+}
+
+int SpsaOptimizer::writeImproved(const string& tunablesFolder, const vector<SpsaBucketResult>& results) {
+    int written = 0;
+    for (const SpsaBucketResult& result : results) {
+        // unverified results, and ties within the noise of the verification games, keep the old file;
+        // a clean sweep needs at least 4 games to clear it
+        const MatchupStats& verification = result.verification;
+        if (verification.games == 0 || verification.winRateLowerBound() <= 0.5) {
+            continue;
+        }
+        const Bucket& bucket = result.bucket;
+        Tunables::writeCsvRows(Tunables::csvPath(tunablesFolder, bucket.nPlayers, bucket.mapSize, bucket.haliteAbundance),
+                               result.tuned);
+        written++;
+    }
+    return written;
+}
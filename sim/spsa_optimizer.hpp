@@ -0,0 +1,67 @@
+#pragma once
+
+#include "tournament_runner.hpp"
+#include "my_helpers/tunables.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+struct SpsaConfig {
+    string tunablesFolder = ".";   // the folder holding the csv folder to tune
+    vector<Bucket> buckets = Bucket::all();
+    int iterations = 50;
+    int gamesPerIteration = 4;     // games per bucket between the two perturbed sets
+    int verifyGames = 20;          // games per bucket between the result and the starting values
+    unsigned int threads = 0;
+    unsigned int seed = 1;
+    int maxTurns = 0;
+    // gain sequences: a_k = a / (k + 1 + A)^alpha, c_k = c / (k + 1)^gamma,
+    // with c in units of each parameter's mut column and A a tenth of the iterations
+    double a = 4.0;
+    double c = 1.0;
+    double alpha = 0.602;
+    double gamma = 0.101;
+};
+
+/// The result for one bucket.
+struct SpsaBucketResult {
+    Bucket bucket;
+    vector<Tunables::CsvRow> start;
+    vector<Tunables::CsvRow> tuned;  // value is the average of the second half of the iterations, spread their range
+    MatchupStats verification;       // tuned against start
+};
+
+/// Tunes every bucket's csv file with simultaneous perturbation stochastic
+/// approximation: each iteration moves all parameters of a bucket at once by
+/// +-c_k * mut, plays the two resulting sets against each other and steps along
+/// the sign of the outcome, so one batch of games estimates the whole gradient
+/// instead of one parameter at a time. All buckets are tuned side by side in
+/// the same tournament to keep every core busy.
+/// Values stay within the csv min and max and int parameters stay whole.
+class SpsaOptimizer {
+public:
+    /// Called after every iteration, with the win rate of the plus side per bucket.
+    typedef function<void(int iteration, const vector<double>& plusWinRates)> Progress;
+
+    explicit SpsaOptimizer(const SpsaConfig& config);
+
+    vector<SpsaBucketResult> run(Progress progress = nullptr);
+
+    /// Overwrite the csv files of the buckets where the tuned values beat the
+    /// starting ones in the verification games: the lower end of the 95%
+    /// Wilson interval of their win rate has to be above one half. Nothing is
+    /// written without verification games.
+    /// Returns how many were written.
+    static int writeImproved(const string& tunablesFolder, const vector<SpsaBucketResult>& results);
+
+private:
+    /// base with the values of rows set to x
+    static Tunables::TunableValues toValues(const Tunables::TunableValues& base, const vector<Tunables::CsvRow>& rows,
+                                            const vector<double>& x);
+    static double clampAndRound(const Tunables::CsvRow& row, double value);
+
+    SpsaConfig config_;
+};
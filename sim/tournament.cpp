@@ -0,0 +1,115 @@
+#include "tournament_runner.hpp"
+#include "hlt/log.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace hlt;
+
+static void usage() {
+    cerr << "usage: tournament [--games n] [--threads n] [--seed n] [--turns n] [--buckets 2-32-0,4-64-2,...] [--csv out.csv]"
+         << " baselineFolder candidateFolder..." << endl
+         << "Each folder holds a csv folder of tunables; with no candidate the baseline plays itself." << endl;
+    exit(1);
+}
+
+static vector<Bucket> parseBuckets(const string& list) {
+    vector<Bucket> buckets;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == string::npos) {
+            end = list.size();
+        }
+        Bucket bucket;
+        if (!Bucket::parse(list.substr(start, end - start), bucket)) {
+            cerr << "unknown bucket " << list.substr(start, end - start) << endl;
+            exit(1);
+        }
+        buckets.push_back(bucket);
+        start = end + 1;
+    }
+    return buckets;
+}
+
+/// Plays candidate sets of tunables against a baseline set across the
+/// buckets, on every core, and reports win rates as games finish.
+int main(int argc, char* argv[]) {
+    TournamentConfig config;
+    string csvPath;
+    vector<string> folders;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg.size() > 2 && arg.compare(0, 2, "--") == 0) {
+            if (i + 1 >= argc) {
+                usage();
+            }
+            string value = argv[++i];
+            if (arg == "--games") config.gamesPerBucket = stoi(value);
+            else if (arg == "--threads") config.threads = unsigned(stoul(value));
+            else if (arg == "--seed") config.seed = unsigned(stoul(value));
+            else if (arg == "--turns") config.maxTurns = stoi(value);
+            else if (arg == "--buckets") config.buckets = parseBuckets(value);
+            else if (arg == "--csv") csvPath = value;
+            else usage();
+        } else {
+            folders.push_back(arg);
+        }
+    }
+    if (folders.empty()) {
+        usage();
+    }
+    if (folders.size() == 1) {
+        folders.push_back(folders[0]);
+    }
+
+    // the bots would otherwise keep every message of every game in memory
+    log::set_level(log::Level::Error);
+
+    Contender baseline = { folders[0], folders[0], {} };
+    vector<Contender> challengers;
+    for (size_t i = 1; i < folders.size(); i++) {
+        challengers.push_back({ folders[i], folders[i], {} });
+    }
+
+    Tournament tournament(config, baseline, challengers);
+    auto start = chrono::steady_clock::now();
+    tournament.run([&](size_t challenger, size_t bucket, int finished, int total) {
+        const MatchupStats& stats = tournament.stats(challenger, bucket);
+        MatchupStats overall = tournament.total(challenger);
+        printf("[%d/%d] %s %s: %.1f%% of %d  overall %.1f%% +-%.1f of %d\n",
+               finished, total, challengers[challenger].name.c_str(), config.buckets[bucket].name().c_str(),
+               100 * stats.winRate(), stats.games,
+               100 * overall.winRate(), 100 * overall.winRateMargin(), overall.games);
+        fflush(stdout);
+    });
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    ofstream csv;
+    if (!csvPath.empty()) {
+        csv.open(csvPath, ios::trunc | ios::out);
+        csv << "challenger,bucket,games,winRate,margin,haliteRatio\n";
+    }
+    for (size_t challenger = 0; challenger < challengers.size(); challenger++) {
+        cout << challengers[challenger].name << " against " << baseline.name << endl;
+        for (size_t bucket = 0; bucket < config.buckets.size(); bucket++) {
+            const MatchupStats& stats = tournament.stats(challenger, bucket);
+            printf("  %-8s win %5.1f%% +-%4.1f  halite x%.3f\n", config.buckets[bucket].name().c_str(),
+                   100 * stats.winRate(), 100 * stats.winRateMargin(), stats.meanHaliteRatio());
+            if (csv.is_open()) {
+                csv << challengers[challenger].name << ',' << config.buckets[bucket].name() << ',' << stats.games << ','
+                    << stats.winRate() << ',' << stats.winRateMargin() << ',' << stats.meanHaliteRatio() << '\n';
+            }
+        }
+        MatchupStats overall = tournament.total(challenger);
+        printf("  overall  win %5.1f%% +-%4.1f  halite x%.3f\n",
+               100 * overall.winRate(), 100 * overall.winRateMargin(), overall.meanHaliteRatio());
+    }
+    int games = int(challengers.size() * config.buckets.size()) * config.gamesPerBucket;
+    cout << games << " games in " << seconds << "s (" << games / seconds * 60 << " games/minute)" << endl;
+    return 0;
+}
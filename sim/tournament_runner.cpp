@@ -0,0 +1,151 @@
+#include "tournament_runner.hpp"
+#include "my_helpers/work_stealing_pool.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+using namespace std;
+
+string Bucket::name() const {
+    return to_string(nPlayers) + '-' + to_string(mapSize) + '-' + to_string(haliteAbundance);
+}
+
+vector<Bucket> Bucket::all() {
+    vector<Bucket> buckets;
+    for (int nPlayers : { 2, 4 }) {
+        for (int mapSize : { 32, 40, 48, 56, 64 }) {
+            for (int haliteAbundance : { 0, 1, 2 }) {
+                buckets.push_back({ nPlayers, mapSize, haliteAbundance });
+            }
+        }
+    }
+    return buckets;
+}
+
+bool Bucket::parse(const string& name, Bucket& bucket) {
+    for (const Bucket& candidate : all()) {
+        if (candidate.name() == name) {
+            bucket = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+double MatchupStats::winRateMargin() const {
+    if (games == 0) {
+        return 1;
+    }
+    double p = winRate();
+    return 1.96 * sqrt(p * (1 - p) / games);
+}
+
+double MatchupStats::winRateLowerBound() const {
+    if (games == 0) {
+        return 0;
+    }
+    const double z = 1.96;
+    const double p = winRate();
+    const double n = games;
+    const double center = p + z * z / (2 * n);
+    const double spread = z * sqrt(p * (1 - p) / n + z * z / (4 * n * n));
+    return (center - spread) / (1 + z * z / n);
+}
+
+void MatchupStats::add(const MatchupStats& other) {
+    games += other.games;
+    wins += other.wins;
+    haliteRatioSum += other.haliteRatioSum;
+}
+
+shared_ptr<const Tunables> Contender::tunables() const {
+    shared_ptr<const Tunables> tunables = Tunables::load(tunablesFolder);
+    for (const auto& override : overrides) {
+        Bucket bucket;
+        if (Bucket::parse(override.first, bucket)) {
+            tunables = tunables->withValues(bucket.nPlayers, bucket.mapSize, bucket.haliteAbundance, override.second);
+        }
+    }
+    return tunables;
+}
+
+Tournament::Tournament(const TournamentConfig& config, const Contender& baseline, const vector<Contender>& challengers) :
+    config_(config), baseline_(baseline), challengers_(challengers),
+    baselineTunables_(baseline.tunables()),
+    stats_(challengers.size(), vector<MatchupStats>(config.buckets.size())),
+    finishedGames_(0), totalGames_(0) {
+    for (const Contender& challenger : challengers_) {
+        challengerTunables_.push_back(challenger.tunables());
+    }
+}
+
+unsigned int Tournament::gameSeed(size_t bucket, int game) const {
+    // splitmix64, so that neighbouring games get unrelated maps
+    unsigned long long z = config_.seed * 0x9E3779B97F4A7C15ULL + bucket * 0xBF58476D1CE4E5B9ULL + game * 0x94D049BB133111EBULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return unsigned(z ^ (z >> 31));
+}
+
+void Tournament::playGame(size_t challenger, size_t bucket, int game) {
+    const Bucket& b = config_.buckets[bucket];
+    SimulationConfig simulation;
+    simulation.mapSize = b.mapSize;
+    simulation.nPlayers = b.nPlayers;
+    simulation.haliteAbundance = b.haliteAbundance;
+    simulation.maxTurns = config_.maxTurns;
+    simulation.seed = gameSeed(bucket, game);
+
+    // alternate the seats so neither side always gets player 0
+    vector<PlayerFactory> seats;
+    vector<bool> challengerSeat;
+    for (int seat = 0; seat < b.nPlayers; seat++) {
+        bool isChallenger = (seat + game) % 2 == 0;
+        const shared_ptr<const Tunables>& tunables = isChallenger ? challengerTunables_[challenger] : baselineTunables_;
+        seats.push_back(Simulator::botPlayer(simulation.seed + seat, tunables));
+        challengerSeat.push_back(isChallenger);
+    }
+    SimulationResult result = Simulator(simulation).run(seats);
+
+    long long challengerHalite = 0;
+    long long baselineHalite = 0;
+    for (int seat = 0; seat < b.nPlayers; seat++) {
+        (challengerSeat[seat] ? challengerHalite : baselineHalite) += result.halite[seat];
+    }
+
+    lock_guard<mutex> lock(statsLock_);
+    MatchupStats& stats = stats_[challenger][bucket];
+    stats.games++;
+    stats.wins += challengerHalite > baselineHalite ? 1 : (challengerHalite == baselineHalite ? 0.5 : 0);
+    stats.haliteRatioSum += double(challengerHalite) / max(baselineHalite, 1LL);
+    finishedGames_++;
+    if (progress_) {
+        progress_(challenger, bucket, finishedGames_, totalGames_);
+    }
+}
+
+void Tournament::run(Progress progress) {
+    progress_ = progress;
+    finishedGames_ = 0;
+    totalGames_ = int(challengers_.size() * config_.buckets.size()) * config_.gamesPerBucket;
+
+    WorkStealingPool pool(config_.threads);
+    // every bucket gets its first games early, so partial results cover all of them
+    for (int game = 0; game < config_.gamesPerBucket; game++) {
+        for (size_t bucket = 0; bucket < config_.buckets.size(); bucket++) {
+            for (size_t challenger = 0; challenger < challengers_.size(); challenger++) {
+                pool.submit([this, challenger, bucket, game] { playGame(challenger, bucket, game); });
+            }
+        }
+    }
+    pool.wait();
+}
+
+MatchupStats Tournament::total(size_t challenger) const {
+    MatchupStats sum;
+    for (const MatchupStats& stats : stats_[challenger]) {
+        sum.add(stats);
+    }
+    return sum;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "simulator.hpp"
+#include "my_helpers/tunables.hpp"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/// One of the tunables csv files: csv/<nPlayers>-<mapSize>-<haliteAbundance>.csv
+struct Bucket {
+    int nPlayers;
+    int mapSize;
+    int haliteAbundance;
+
+    string name() const;
+
+    /// All 30 buckets, in csv file order.
+    static vector<Bucket> all();
+    /// Parse a name such as "2-32-0"; returns false if it is not a bucket.
+    static bool parse(const string& name, Bucket& bucket);
+};
+
+/// A set of tunables taking part in a tournament.
+struct Contender {
+    string name;
+    string tunablesFolder; // the folder holding its csv folder
+    // values to play with instead of the csv row, by bucket name
+    map<string, Tunables::TunableValues> overrides;
+
+    /// The folder's tunables with the overrides applied.
+    shared_ptr<const Tunables> tunables() const;
+};
+
+struct TournamentConfig {
+    int gamesPerBucket = 10;
+    unsigned int threads = 0;  // 0 uses every hardware thread
+    unsigned int seed = 1;     // game seeds are derived from it, bucket and game number
+    int maxTurns = 0;          // 0 plays full games
+    vector<Bucket> buckets = Bucket::all();
+};
+
+/// How a challenger did against the baseline.
+struct MatchupStats {
+    int games = 0;
+    double wins = 0;             // a tie counts as half a win
+    double haliteRatioSum = 0;   // challenger halite / baseline halite, summed over games
+
+    double winRate() const { return games ? wins / games : 0; }
+    double meanHaliteRatio() const { return games ? haliteRatioSum / games : 0; }
+    /// Half width of the 95% confidence interval of the win rate.
+    double winRateMargin() const;
+    /// Lower end of the 95% Wilson score interval of the win rate. Unlike
+    /// winRate() - winRateMargin(), it stays well below a perfect record
+    /// over a handful of games.
+    double winRateLowerBound() const;
+    void add(const MatchupStats& other);
+};
+
+/// Plays every challenger against the baseline in simulated games, in
+/// parallel, and collects win rates per bucket.
+/// Every challenger plays the same maps with the same seeds, seated as the
+/// baseline in half of the games, so results only depend on the config and
+/// differences between challengers are not down to luck of the draw.
+class Tournament {
+public:
+    /// Called after every finished game, one call at a time.
+    typedef function<void(size_t challenger, size_t bucket, int finishedGames, int totalGames)> Progress;
+
+    Tournament(const TournamentConfig& config, const Contender& baseline, const vector<Contender>& challengers);
+
+    void run(Progress progress = nullptr);
+
+    const MatchupStats& stats(size_t challenger, size_t bucket) const { return stats_[challenger][bucket]; }
+    MatchupStats total(size_t challenger) const;
+
+    const TournamentConfig& config() const { return config_; }
+    const vector<Contender>& challengers() const { return challengers_; }
+
+    /// The seed of a game; the same for every challenger.
+    unsigned int gameSeed(size_t bucket, int game) const;
+
+private:
+    void playGame(size_t challenger, size_t bucket, int game);
+
+    TournamentConfig config_;
+    Contender baseline_;
+    vector<Contender> challengers_;
+    shared_ptr<const Tunables> baselineTunables_;
+    vector<shared_ptr<const Tunables>> challengerTunables_;
+    vector<vector<MatchupStats>> stats_; // [challenger][bucket]
+
+    mutex statsLock_;
+    Progress progress_;
+    int finishedGames_;
+    int totalGames_;
+};
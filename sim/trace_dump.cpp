@@ -0,0 +1,76 @@
+#include "my_helpers/trace.hpp"
+
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+/// Prints a trace file written with TraceWriter, one line per turn.
+///
+/// Usage: trace_dump <trace file> [turn]
+/// With a turn, also lists that turn's ships, targets, intents and commands.
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "usage: trace_dump <trace file> [turn]" << endl;
+        return 1;
+    }
+    int detailTurn = argc > 2 ? stoi(argv[2]) : -1;
+
+    TraceReader reader;
+    if (!reader.open(argv[1])) {
+        cerr << argv[1] << ": " << reader.error() << endl;
+        return 1;
+    }
+    cout << "player " << reader.playerId() << ", map " << reader.width() << 'x' << reader.height()
+         << ", header " << reader.position() << " bytes" << endl;
+
+    TraceTurn turn;
+    int turns = 0;
+    size_t before = reader.position();
+    while (reader.next(turn)) {
+        size_t bytes = reader.position() - before;
+        before = reader.position();
+        turns++;
+        cout << "turn " << turn.turn << ": " << bytes << " bytes, "
+             << turn.haliteChanges.size() << " cells changed, "
+             << turn.ships.size() << " ships, "
+             << turn.targets.size() << " targets, "
+             << turn.intents.size() << " intents, "
+             << turn.commands.size() << " commands" << endl;
+        if (turn.turn != detailTurn) {
+            continue;
+        }
+        for (const TraceTurn::Ship& ship : turn.ships) {
+            cout << "  ship " << ship.id << " at " << ship.cell % reader.width() << ',' << ship.cell / reader.width()
+                 << " halite " << ship.halite << " status " << static_cast<int>(ship.status) << endl;
+        }
+        for (const TraceTurn::Target& target : turn.targets) {
+            cout << "  target " << target.ship << " -> "
+                 << target.cell % reader.width() << ',' << target.cell / reader.width() << endl;
+        }
+        size_t first = 0;
+        for (const TraceTurn::Intent& intent : turn.intents) {
+            cout << "  intent " << intent.ship << ':';
+            for (size_t i = first; i < first + intent.count; i++) {
+                cout << ' ' << static_cast<char>(turn.intentDirections[i]);
+            }
+            cout << endl;
+            first += intent.count;
+        }
+        for (const TraceTurn::Command& command : turn.commands) {
+            cout << "  command " << command.kind;
+            if (command.kind != 'g') {
+                cout << ' ' << command.ship;
+            }
+            if (command.kind == 'm') {
+                cout << ' ' << static_cast<char>(command.direction);
+            }
+            cout << endl;
+        }
+    }
+    if (reader.position() < reader.size() && !reader.error().empty()) {
+        cerr << argv[1] << ": " << reader.error() << endl;
+    }
+    cout << turns << " turns, " << reader.size() << " bytes" << endl;
+    return 0;
+}
@@ -0,0 +1,223 @@
+#include "hlt/game.hpp"
+#include "my_helpers/assignment.hpp"
+#include "my_helpers/movement_map.hpp"
+#include "my_helpers/turn_budget.hpp"
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace hlt;
+
+/// Checks MinCostMatcher and the movement map's matching, component by
+/// component, against cases solved by hand. Exits with 1 if any check fails.
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << endl; \
+            failures++; \
+        } \
+    } while (false)
+
+static const double F = MinCostMatcher::FORBIDDEN;
+
+static double totalCost(int cols, const vector<double>& cost, const vector<int>& rowColumn) {
+    double total = 0;
+    for (size_t row = 0; row < rowColumn.size(); row++) {
+        total += cost[row * cols + rowColumn[row]];
+    }
+    return total;
+}
+
+static bool distinct(const vector<int>& rowColumn) {
+    return set<int>(rowColumn.begin(), rowColumn.end()).size() == rowColumn.size();
+}
+
+static void testMatcher() {
+    // one matcher for all the cases, so they also check that its buffers are reused correctly
+    MinCostMatcher matcher;
+    vector<int> rowColumn;
+
+    // the only assignment of cost 5; the greedy row by row pick costs 6
+    const vector<double> square = {
+        4, 1, 3,
+        2, 0, 5,
+        3, 2, 2,
+    };
+    CHECK(matcher.solve(3, 3, square, rowColumn));
+    CHECK((rowColumn == vector<int>{ 1, 0, 2 }));
+
+    // more cells than ships: two of the columns stay unused
+    const vector<double> wide = {
+        5, 3, 9, 1,
+        2, 8, 1, 7,
+    };
+    CHECK(matcher.solve(2, 4, wide, rowColumn));
+    CHECK((rowColumn == vector<int>{ 3, 2 }));
+
+    // ties: any permutation is optimal, but it must be one, and the same every time
+    const vector<double> ties(9, 1.0);
+    CHECK(matcher.solve(3, 3, ties, rowColumn));
+    CHECK(distinct(rowColumn));
+    CHECK(totalCost(3, ties, rowColumn) == 3);
+    vector<int> again;
+    matcher.solve(3, 3, ties, again);
+    CHECK(again == rowColumn);
+
+    // row 1 would rather have column 0, but row 0 can have nothing else
+    const vector<double> forced = {
+        1, F,
+        0, 5,
+    };
+    CHECK(matcher.solve(2, 2, forced, rowColumn));
+    CHECK((rowColumn == vector<int>{ 0, 1 }));
+
+    // row 0 cannot be matched at all
+    const vector<double> infeasible = {
+        F, F,
+        1, 1,
+    };
+    CHECK(!matcher.solve(2, 2, infeasible, rowColumn));
+
+    // back to the first case after the others
+    CHECK(matcher.solve(3, 3, square, rowColumn));
+    CHECK((rowColumn == vector<int>{ 1, 0, 2 }));
+}
+
+/// An empty 8x8 map with ships placed by hand, and a movement map for player 0.
+class TestGame {
+public:
+    explicit TestGame(int nPlayers) {
+        Constants constants;
+        constants.MAX_HALITE = 1000;
+        // the shipyards sit on the bottom row, away from the ships
+        vector<shared_ptr<Player>> players;
+        for (PlayerId id = 0; id < nPlayers; id++) {
+            players.push_back(make_shared<Player>(id, 7 - id, 7));
+        }
+        game_ = make_unique<Game>(constants, 0, players, GameMap::_generate(8, 8, vector<Halite>(64, 0)));
+        game_->ship_pool.begin_frame();
+        for (const auto& player : game_->players) {
+            player->_begin_update(game_->ship_pool, 0);
+        }
+    }
+
+    /// Add a ship of owner; returns its id.
+    EntityId addShip(PlayerId owner, int x, int y, Halite halite) {
+        const EntityId id = nextId_++;
+        game_->players[owner]->_update_ship(game_->ship_pool, Ship(owner, id, x, y, halite));
+        return id;
+    }
+
+    /// The move every ship of player 0 makes, given the directions each would like best first.
+    map<EntityId, Direction> resolve(const map<EntityId, vector<Direction>>& intents) {
+        game_->_finish_frame();
+        MovementMap movementMap(game_->game_map, game_->me, int(game_->players.size()), game_->constants.MAX_HALITE);
+        TurnBudget budget = TurnBudget::unlimited();
+        movementMap.startTurn(false, game_->boards, budget);
+        for (const auto& intent : intents) {
+            Ship* ship = game_->me->ships.at(intent.first);
+            movementMap.addIntent(ship, pmr::vector<Direction>(intent.second.begin(), intent.second.end()));
+        }
+        map<EntityId, Direction> moves;
+        for (const Command& command : movementMap.processOutputs(game_->me)) {
+            // "m <id> <direction>"
+            const size_t space = command.rfind(' ');
+            moves[stoi(command.substr(2, space - 2))] = Direction(command.back());
+        }
+        return moves;
+    }
+
+    /// Where the ship ends up after the move.
+    Position destination(EntityId id, Direction direction) {
+        Ship* ship = game_->me->ships.at(id);
+        return game_->game_map->normalize(ship->position.directional_offset(direction));
+    }
+
+private:
+    unique_ptr<Game> game_;
+    EntityId nextId_ = 0;
+};
+
+static void testComponents() {
+    TestGame test(2);
+    // a cell two ships want: the one carrying more halite pays more for
+    // every step down its list, so it gets the cell
+    const EntityId empty = test.addShip(0, 1, 1, 0);
+    const EntityId loaded = test.addShip(0, 3, 1, 500);
+    // a swap, which no two ships doing their best in turn could agree on
+    const EntityId swapLeft = test.addShip(0, 1, 4, 0);
+    const EntityId swapRight = test.addShip(0, 2, 4, 0);
+    // a tie: exactly one of them gets the cell
+    const EntityId tieLeft = test.addShip(0, 1, 6, 0);
+    const EntityId tieRight = test.addShip(0, 3, 6, 0);
+    // a chain: the front ship makes room for the one behind
+    const EntityId front = test.addShip(0, 5, 2, 0);
+    const EntityId behind = test.addShip(0, 5, 3, 0);
+
+    map<EntityId, Direction> moves = test.resolve({
+        { empty, { Direction::EAST } },
+        { loaded, { Direction::WEST } },
+        { swapLeft, { Direction::EAST } },
+        { swapRight, { Direction::WEST } },
+        { tieLeft, { Direction::EAST } },
+        { tieRight, { Direction::WEST } },
+        { front, { Direction::NORTH } },
+        { behind, { Direction::NORTH } },
+    });
+    CHECK(moves.size() == 8);
+    CHECK(moves[empty] == Direction::STILL);
+    CHECK(moves[loaded] == Direction::WEST);
+    CHECK(moves[swapLeft] == Direction::EAST);
+    CHECK(moves[swapRight] == Direction::WEST);
+    CHECK((moves[tieLeft] == Direction::STILL) != (moves[tieRight] == Direction::STILL));
+    CHECK(moves[front] == Direction::NORTH);
+    CHECK(moves[behind] == Direction::NORTH);
+
+    set<Position> destinations;
+    for (const auto& move : moves) {
+        destinations.insert(test.destination(move.first, move.second));
+    }
+    CHECK(destinations.size() == moves.size());
+}
+
+static void testEnemyShips() {
+    TestGame test(4);
+    // boxed in by our own ships that stay, the only way out is onto an enemy:
+    // however far down its list staying is, the ship stays
+    const EntityId boxed = test.addShip(0, 2, 2, 900);
+    const EntityId north = test.addShip(0, 2, 1, 0);
+    const EntityId south = test.addShip(0, 2, 3, 0);
+    const EntityId west = test.addShip(0, 1, 2, 0);
+    test.addShip(1, 3, 2, 0);
+
+    map<EntityId, Direction> moves = test.resolve({
+        { boxed, { Direction::EAST, Direction::NORTH, Direction::SOUTH, Direction::WEST } },
+        { north, { Direction::STILL } },
+        { south, { Direction::STILL } },
+        { west, { Direction::STILL } },
+    });
+    CHECK(moves[boxed] == Direction::STILL);
+    CHECK(moves[north] == Direction::STILL);
+    CHECK(moves[south] == Direction::STILL);
+    CHECK(moves[west] == Direction::STILL);
+}
+
+int main() {
+    testMatcher();
+    testComponents();
+    testEnemyShips();
+    if (failures > 0) {
+        cerr << failures << " checks failed" << endl;
+        return 1;
+    }
+    cout << "all checks passed" << endl;
+    return 0;
+}
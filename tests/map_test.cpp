@@ -0,0 +1,165 @@
+#include "hlt/distance_field.hpp"
+#include "hlt/game_map.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace hlt;
+
+/// Checks the map's lookup tables against brute force on small odd-sized
+/// maps, where every window and distance wraps around an edge somewhere.
+/// Exits with 1 if any check fails.
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << endl; \
+            failures++; \
+        } \
+    } while (false)
+
+static const int WIDTH = 7;
+static const int HEIGHT = 5;
+
+static vector<Halite> randomHalite(mt19937& rng) {
+    uniform_int_distribution<int> amount(0, 1000);
+    vector<Halite> halite(WIDTH * HEIGHT);
+    for (Halite& cell : halite) {
+        cell = amount(rng);
+    }
+    return halite;
+}
+
+/// The halite of the window, cell by cell; a window wider than the map
+/// counts each column once.
+static long long bruteRectangle(const vector<Halite>& halite, int cx, int cy, int radiusX, int radiusY) {
+    const int columns = min(2 * radiusX + 1, WIDTH);
+    const int rows = min(2 * radiusY + 1, HEIGHT);
+    const int x0 = 2 * radiusX + 1 >= WIDTH ? 0 : cx - radiusX;
+    const int y0 = 2 * radiusY + 1 >= HEIGHT ? 0 : cy - radiusY;
+    long long total = 0;
+    for (int y = y0; y < y0 + rows; y++) {
+        for (int x = x0; x < x0 + columns; x++) {
+            total += halite[wrap_coordinate(y, HEIGHT) * WIDTH + wrap_coordinate(x, WIDTH)];
+        }
+    }
+    return total;
+}
+
+static void testRectangles() {
+    mt19937 rng(7);
+    vector<Halite> halite = randomHalite(rng);
+    shared_ptr<GameMap> map = GameMap::_generate(WIDTH, HEIGHT, halite);
+
+    for (int round = 0; round < 2; round++) {
+        CHECK(map->total_halite() == bruteRectangle(halite, 0, 0, WIDTH, HEIGHT));
+        // centers off the map too, which have to wrap before the window does
+        for (int cy = -HEIGHT; cy < 2 * HEIGHT; cy++) {
+            for (int cx = -WIDTH; cx < 2 * WIDTH; cx++) {
+                for (int radiusY = 0; radiusY <= HEIGHT; radiusY++) {
+                    for (int radiusX = 0; radiusX <= WIDTH; radiusX++) {
+                        CHECK(map->rectangle_halite(Position(cx, cy), radiusX, radiusY) ==
+                              bruteRectangle(halite, cx, cy, radiusX, radiusY));
+                    }
+                }
+            }
+        }
+        // the table follows the map's updates
+        halite = randomHalite(rng);
+        map->_update(halite);
+    }
+}
+
+static void testDiamonds() {
+    // on an even map the diamond's estimate is exact whenever the square it
+    // is taken from fits on the map, wherever the window wraps
+    const Halite EVEN = 10;
+    shared_ptr<GameMap> map = GameMap::_generate(WIDTH, HEIGHT, vector<Halite>(WIDTH * HEIGHT, EVEN));
+    for (int radius = 0; radius <= 2; radius++) {
+        const long long cells = 2LL * radius * radius + 2LL * radius + 1;
+        for (int cy = 0; cy < HEIGHT; cy++) {
+            for (int cx = 0; cx < WIDTH; cx++) {
+                CHECK(map->diamond_halite(Position(cx, cy), radius) == EVEN * cells);
+            }
+        }
+    }
+
+    // radius 0 is the cell itself
+    mt19937 rng(11);
+    const vector<Halite> halite = randomHalite(rng);
+    map = GameMap::_generate(WIDTH, HEIGHT, halite);
+    for (int cy = -1; cy <= HEIGHT; cy++) {
+        for (int cx = -1; cx <= WIDTH; cx++) {
+            CHECK(map->diamond_halite(Position(cx, cy), 0) ==
+                  halite[wrap_coordinate(cy, HEIGHT) * WIDTH + wrap_coordinate(cx, WIDTH)]);
+        }
+    }
+}
+
+/// Toroidal distance along one axis, by trying every way around.
+static int bruteDelta(int a, int b, int size) {
+    int best = abs(a - b);
+    for (int k = -4; k <= 4; k++) {
+        best = min(best, abs(a - b + k * size));
+    }
+    return best;
+}
+
+static void testDistances() {
+    shared_ptr<GameMap> map = GameMap::_generate(WIDTH, HEIGHT, vector<Halite>(WIDTH * HEIGHT, 0));
+
+    // inside the tables' range, and past it where the map falls back to modulo
+    for (int x = -3 * WIDTH; x < 4 * WIDTH; x++) {
+        CHECK(map->normalize(Position(x, 0)).x == ((x % WIDTH) + WIDTH) % WIDTH);
+    }
+    for (int y = -3 * HEIGHT; y < 4 * HEIGHT; y++) {
+        CHECK(map->normalize(Position(0, y)).y == ((y % HEIGHT) + HEIGHT) % HEIGHT);
+    }
+    for (int y1 = -HEIGHT; y1 < 2 * HEIGHT; y1++) {
+        for (int x1 = -WIDTH; x1 < 2 * WIDTH; x1++) {
+            for (int y2 = -2 * HEIGHT; y2 < 3 * HEIGHT; y2++) {
+                for (int x2 = -2 * WIDTH; x2 < 3 * WIDTH; x2++) {
+                    CHECK(map->calculate_distance(Position(x1, y1), Position(x2, y2)) ==
+                          bruteDelta(x1, x2, WIDTH) + bruteDelta(y1, y2, HEIGHT));
+                }
+            }
+        }
+    }
+
+    // a field with sources added one by one, some given off the map
+    const vector<Position> sources = { Position(0, 0), Position(-1, 7), Position(12, 2), Position(3, 3) };
+    DistanceField field;
+    for (size_t added = 0; added < sources.size(); added++) {
+        field.add_source(*map, sources[added]);
+        CHECK(field.source_count == int(added + 1));
+        for (int y = 0; y < HEIGHT; y++) {
+            for (int x = 0; x < WIDTH; x++) {
+                int closest = WIDTH + HEIGHT;
+                for (size_t i = 0; i <= added; i++) {
+                    closest = min(closest, bruteDelta(x, sources[i].x, WIDTH) + bruteDelta(y, sources[i].y, HEIGHT));
+                }
+                CHECK(field.at(*map, Position(x, y)) == closest);
+                CHECK(field.at(*map, Position(x - WIDTH, y + HEIGHT)) == closest);
+            }
+        }
+    }
+}
+
+int main() {
+    testRectangles();
+    testDiamonds();
+    testDistances();
+    if (failures > 0) {
+        cerr << failures << " checks failed" << endl;
+        return 1;
+    }
+    cout << "all checks passed" << endl;
+    return 0;
+}
@@ -0,0 +1,265 @@
+#include "hlt/game_map.hpp"
+#include "my_helpers/trace.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace hlt;
+
+/// Writes trace files with TraceWriter and reads them back with TraceReader:
+/// whole, cut short at every byte of the last record, padded with zeros as an
+/// unclosed or crashed writer leaves them, and with a damaged record.
+/// Exits with 1 if any check fails.
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << endl; \
+            failures++; \
+        } \
+    } while (false)
+
+static const int WIDTH = 6;
+static const int HEIGHT = 5;
+static const string PATH = "trace_test.bin";
+
+static vector<Halite> initialHalite() {
+    vector<Halite> halite;
+    for (int cell = 0; cell < WIDTH * HEIGHT; cell++) {
+        // some of them take more than one varint byte
+        halite.push_back(cell * 97 % 1000);
+    }
+    return halite;
+}
+
+/// Turns covering what the format squeezes: halite going up and down, ids
+/// far apart and out of order, every kind of command, and an empty turn.
+static vector<TraceTurn> sampleTurns() {
+    vector<TraceTurn> turns(4);
+
+    turns[0].turn = 1;
+    turns[0].haliteChanges = { { 29, 0 }, { 3, 1000 } };
+    turns[0].ships = { { 0, 7, 0, 0 } };
+    turns[0].commands = { { 'g', -1, Direction::STILL } };
+
+    turns[1].turn = 2;
+    turns[1].haliteChanges = { { 7, 150 } };
+    turns[1].ships = { { 300, 8, 999, 2 }, { 0, 14, 50, 1 } };
+    turns[1].targets = { { 300, 20 }, { 0, 1 } };
+    turns[1].intents = { { 300, 2 }, { 0, 1 } };
+    turns[1].intentDirections = { Direction::EAST, Direction::STILL, Direction::NORTH };
+    turns[1].addCommand("m 300 e");
+    turns[1].addCommand("m 0 n");
+
+    turns[2].turn = 3;
+
+    turns[3].turn = 5;
+    turns[3].haliteChanges = { { 0, 12 }, { 29, 700 } };
+    turns[3].ships = { { 300, 9, 1000, 3 } };
+    turns[3].addCommand("c 300");
+    return turns;
+}
+
+static bool sameTurn(const TraceTurn& a, const TraceTurn& b) {
+    if (a.turn != b.turn || a.haliteChanges != b.haliteChanges || a.intentDirections != b.intentDirections ||
+        a.ships.size() != b.ships.size() || a.targets.size() != b.targets.size() ||
+        a.intents.size() != b.intents.size() || a.commands.size() != b.commands.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.ships.size(); i++) {
+        if (a.ships[i].id != b.ships[i].id || a.ships[i].cell != b.ships[i].cell ||
+            a.ships[i].halite != b.ships[i].halite || a.ships[i].status != b.ships[i].status) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < a.targets.size(); i++) {
+        if (a.targets[i].ship != b.targets[i].ship || a.targets[i].cell != b.targets[i].cell) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < a.intents.size(); i++) {
+        if (a.intents[i].ship != b.intents[i].ship || a.intents[i].count != b.intents[i].count) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < a.commands.size(); i++) {
+        if (a.commands[i].kind != b.commands[i].kind || a.commands[i].ship != b.commands[i].ship ||
+            a.commands[i].direction != b.commands[i].direction) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// The turns as the reader gives them back: ships and targets sorted by id,
+/// the rest as written.
+static vector<TraceTurn> expectedTurns() {
+    vector<TraceTurn> turns = sampleTurns();
+    for (TraceTurn& turn : turns) {
+        sort(turn.haliteChanges.begin(), turn.haliteChanges.end());
+        sort(turn.ships.begin(), turn.ships.end(),
+             [](const TraceTurn::Ship& a, const TraceTurn::Ship& b) { return a.id < b.id; });
+        sort(turn.targets.begin(), turn.targets.end(),
+             [](const TraceTurn::Target& a, const TraceTurn::Target& b) { return a.ship < b.ship; });
+    }
+    return turns;
+}
+
+static vector<uint8_t> readBytes(const string& path) {
+    ifstream in(path, ios::binary);
+    return vector<uint8_t>(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+static void writeBytes(const string& path, const vector<uint8_t>& bytes) {
+    ofstream out(path, ios::binary | ios::trunc);
+    out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+/// Reads the whole file; returns the turns read, and where reading stopped.
+static vector<TraceTurn> readAll(const string& path, size_t& position, string& error) {
+    vector<TraceTurn> turns;
+    TraceReader reader;
+    if (!reader.open(path)) {
+        error = reader.error();
+        position = 0;
+        return turns;
+    }
+    TraceTurn turn;
+    while (reader.next(turn)) {
+        turns.push_back(turn);
+        // the map the reader keeps follows the changes
+        for (const auto& change : turn.haliteChanges) {
+            CHECK(reader.halite()[change.first] == change.second);
+        }
+    }
+    position = reader.position();
+    error = reader.error();
+    return turns;
+}
+
+/// Writes the sample turns to PATH; returns where each record ends, from
+/// writing the first one, two, ... of them.
+static vector<size_t> writeSample() {
+    shared_ptr<GameMap> map = GameMap::_generate(WIDTH, HEIGHT, initialHalite());
+    const vector<TraceTurn> turns = sampleTurns();
+    vector<size_t> recordEnds;
+    for (size_t count = 1; count <= turns.size(); count++) {
+        TraceWriter writer;
+        CHECK(writer.open(PATH, 1, *map));
+        for (size_t i = 0; i < count; i++) {
+            writer.write(turns[i]);
+        }
+        writer.close();
+        recordEnds.push_back(readBytes(PATH).size());
+    }
+    return recordEnds;
+}
+
+static void testRoundTrip(const vector<uint8_t>& file) {
+    writeBytes(PATH, file);
+    size_t position;
+    string error;
+    vector<TraceTurn> turns = readAll(PATH, position, error);
+    const vector<TraceTurn> expected = expectedTurns();
+    CHECK(turns.size() == expected.size());
+    for (size_t i = 0; i < turns.size() && i < expected.size(); i++) {
+        CHECK(sameTurn(turns[i], expected[i]));
+    }
+    CHECK(position == file.size());
+    CHECK(error.empty());
+
+    TraceReader reader;
+    CHECK(reader.open(PATH));
+    CHECK(reader.playerId() == 1);
+    CHECK(reader.width() == WIDTH);
+    CHECK(reader.height() == HEIGHT);
+    CHECK(reader.halite() == initialHalite());
+}
+
+static void testTruncated(const vector<uint8_t>& file, const vector<size_t>& recordEnds) {
+    const size_t lastStart = recordEnds[recordEnds.size() - 2];
+    const size_t turnsBefore = recordEnds.size() - 1;
+
+    // cut anywhere inside the last record: the turns before it, and an error
+    for (size_t size = lastStart + 1; size < file.size(); size++) {
+        writeBytes(PATH, vector<uint8_t>(file.begin(), file.begin() + size));
+        size_t position;
+        string error;
+        vector<TraceTurn> turns = readAll(PATH, position, error);
+        CHECK(turns.size() == turnsBefore);
+        CHECK(position == lastStart);
+        CHECK(!error.empty());
+    }
+
+    // the last record's length written, its body still the zeros of the
+    // mapping: not an empty turn, but a record cut short
+    for (size_t kept = lastStart + 1; kept < file.size(); kept++) {
+        vector<uint8_t> padded(file.begin(), file.begin() + kept);
+        padded.resize(file.size() + 4096, 0);
+        writeBytes(PATH, padded);
+        size_t position;
+        string error;
+        vector<TraceTurn> turns = readAll(PATH, position, error);
+        CHECK(turns.size() == turnsBefore);
+        CHECK(!error.empty());
+    }
+
+    // a writer that was never closed: every record whole, then zeros
+    vector<uint8_t> unclosed = file;
+    unclosed.resize(file.size() + 4096, 0);
+    writeBytes(PATH, unclosed);
+    size_t position;
+    string error;
+    vector<TraceTurn> turns = readAll(PATH, position, error);
+    CHECK(turns.size() == recordEnds.size());
+    CHECK(position == file.size());
+    CHECK(error.empty());
+}
+
+static void testDamaged(const vector<uint8_t>& file, const vector<size_t>& recordEnds) {
+    // a flipped bit in the second record's body fails its checksum
+    vector<uint8_t> damaged = file;
+    damaged[recordEnds[0] + 2] ^= 0x10;
+    writeBytes(PATH, damaged);
+    size_t position;
+    string error;
+    vector<TraceTurn> turns = readAll(PATH, position, error);
+    CHECK(turns.size() == 1);
+    CHECK(position == recordEnds[0]);
+    CHECK(!error.empty());
+
+    // not a trace at all
+    vector<uint8_t> notTrace = file;
+    notTrace[0] = 'X';
+    writeBytes(PATH, notTrace);
+    TraceReader reader;
+    CHECK(!reader.open(PATH));
+    CHECK(!reader.error().empty());
+}
+
+int main() {
+    const vector<size_t> recordEnds = writeSample();
+    const vector<uint8_t> file = readBytes(PATH);
+    CHECK(recordEnds.size() == sampleTurns().size());
+    CHECK(!recordEnds.empty() && recordEnds.back() == file.size());
+
+    testRoundTrip(file);
+    testTruncated(file, recordEnds);
+    testDamaged(file, recordEnds);
+    remove(PATH.c_str());
+
+    if (failures > 0) {
+        cerr << failures << " checks failed" << endl;
+        return 1;
+    }
+    cout << "all checks passed" << endl;
+    return 0;
+}